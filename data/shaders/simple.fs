@@ -3,10 +3,22 @@
 layout(location = 0) out vec4 color;
 
 uniform sampler2D tex;
+// Texels hold the two bytes of a big endian RGBA5551 pixel instead of a color
+uniform bool rgba5551;
 
 in vec2 frag_uv;
 
 void main()
 {
-    color = texture(tex, frag_uv);
+    vec4 texel = texture(tex, frag_uv);
+    if (rgba5551)
+    {
+        uint pixel = uint(texel.r * 255.0 + 0.5) << 8 | uint(texel.g * 255.0 + 0.5);
+        uvec3 rgb = uvec3(pixel >> 11, pixel >> 6, pixel >> 1) & 0x1Fu;
+        color = vec4(vec3(rgb) / 31.0, 1.0);
+    }
+    else
+    {
+        color = texel;
+    }
 }
\ No newline at end of file
@@ -1,7 +1,9 @@
 #pragma once
 
 #include <cstdint>
-#include <future>
+#include <functional>
+#include <span>
+#include <string>
 #include <vector>
 
 namespace hydra
@@ -51,6 +53,7 @@ namespace hydra
     enum class VideoFormat
     {
         RGBA8888,
+        // 16 bits per pixel in big endian order, with 5 bits per color and 1 bit of alpha
         RGBA5551,
     };
 
@@ -58,7 +61,12 @@ namespace hydra
     {
         std::vector<uint8_t> data{};
         uint32_t width = 0, height = 0;
+        // Bytes from the start of one row to the next
+        uint32_t stride = 0;
         VideoFormat format;
+        // The picture is the same as the last frame's. Nothing else was written, so a buffer
+        // handed out by the frontend may still hold an older frame
+        bool repeat = false;
     };
 
     struct AudioInfo
@@ -82,19 +90,65 @@ namespace hydra
         Core& operator=(Core&&) = default;
 
         virtual bool LoadFile(const std::string& type, const std::string& path) = 0;
-        std::future<void> RunFrameAsync();
+        // Runs on the calling thread, frontends call it from their emulation thread
+        void RunFrame();
         virtual void Reset() = 0;
         virtual void SetVideoCallback(std::function<void(const VideoInfo&)> callback) = 0;
+
+        // Lets the frontend hand out the buffer each frame is drawn into, which the video
+        // callback then receives. Its data is resized in place, so buffers that are reused keep
+        // their allocation. Without one frames go into a buffer owned by the core
+        void SetVideoBufferCallback(std::function<VideoInfo&()> callback)
+        {
+            video_buffer_callback_ = callback;
+        }
         virtual void SetAudioCallback(std::function<void(const AudioInfo&)> callback) = 0;
         virtual void SetPollInputCallback(std::function<void()> callback) = 0;
         virtual void SetReadInputCallback(std::function<int8_t(const InputInfo&)> callback) = 0;
 
+        // Serializes the whole emulator state into buffer, replacing its contents. Reusing the
+        // same buffer for every snapshot avoids reallocating it. Neither may be called while a
+        // frame is running. Both return false if the core doesn't support save states
+        virtual bool SaveState(std::vector<uint8_t>&)
+        {
+            return false;
+        }
+
+        virtual bool LoadState(std::span<const uint8_t>)
+        {
+            return false;
+        }
+
+        // Scales the rate audio is resampled to. Frontends nudge it slightly around 1 from the
+        // audio callback to keep their queue from draining or filling up
+        void SetAudioRateAdjust(double adjust)
+        {
+            audio_rate_adjust_ = adjust;
+        }
+
+        // Frontends that can draw RGBA5551 frames opt in here, so cores that render 16 bit pixels
+        // don't have to expand them. Frames are always RGBA8888 otherwise
+        void SetRGBA5551Supported(bool supported)
+        {
+            rgba5551_supported_ = supported;
+        }
+
     protected:
+        VideoInfo& acquire_video_buffer()
+        {
+            return video_buffer_callback_ ? video_buffer_callback_() : video_buffer_;
+        }
+
         int host_sample_rate_ = 48000;
+        double audio_rate_adjust_ = 1.0;
+        bool rgba5551_supported_ = false;
 
     private:
         virtual void run_frame() = 0;
 
+        std::function<VideoInfo&()> video_buffer_callback_;
+        VideoInfo video_buffer_;
+
         Core(const Core&) = delete;
         Core& operator=(const Core&) = delete;
     };
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace hydra
+{
+    // Runs frames on a thread of its own at a fixed rate, so whoever drives the emulator never
+    // blocks on it. When a frame runs long the next ones start right away until the runner is
+    // caught up, or it gives up on catching up if it fell too far behind
+    class CoreRunner final
+    {
+    public:
+        // frame is called on the runner's thread once per frame
+        CoreRunner(std::function<void()> frame, double frame_rate = 60.0);
+        ~CoreRunner();
+        CoreRunner(const CoreRunner&) = delete;
+        CoreRunner& operator=(const CoreRunner&) = delete;
+
+        void SetPaused(bool paused);
+
+        // Runs task on the runner's thread before the next frame, even while paused. Doesn't
+        // wait for it
+        void Post(std::function<void()> task);
+
+    private:
+        void loop();
+        void run_tasks(std::unique_lock<std::mutex>& lock);
+
+        std::function<void()> frame_;
+        std::chrono::steady_clock::duration period_;
+        std::thread thread_;
+        std::mutex mutex_;
+        std::condition_variable cv_;
+        std::vector<std::function<void()>> tasks_;
+        bool paused_ = false;
+        bool quit_ = false;
+    };
+} // namespace hydra
@@ -3,7 +3,10 @@
 #include <fmt/color.h>
 #include <fmt/core.h>
 #include <fmt/format.h>
+#include <atomic>
 #include <functional>
+#include <memory>
+#include <mutex>
 #include <str_hash.hxx>
 #include <unordered_map>
 #include <vector>
@@ -34,11 +37,14 @@ struct Logger
 
         std::string msg = fmt::format(fmt, std::forward<T>(args)...);
         uint32_t hash = str_hash(msg);
-        if (warnings[hash])
-            return;
+        {
+            std::lock_guard<std::mutex> lock(get_mutex());
+            if (warnings[hash])
+                return;
+            warnings[hash] = true;
+        }
 
         Logger::Warn("{}", msg);
-        warnings[hash] = true;
     }
 
     template <typename... T>
@@ -51,40 +57,77 @@ struct Logger
     template <typename... T>
     static void Debug([[maybe_unused]] fmt::format_string<T...> fmt, [[maybe_unused]] T&&... args)
     {
+        // Logged on hot paths like interrupts and TLB misses, don't even format unless shown
+        if (!has_callbacks("Debug"))
+        {
+            return;
+        }
         std::string str = fmt::format(fmt, std::forward<T>(args)...);
         log_impl("Debug", str);
     }
 
     static void ClearWarnings()
     {
+        std::lock_guard<std::mutex> lock(get_mutex());
         get_warnings().clear();
     }
 
-    static LoggingCallbacks& GetCallbacks()
+    static std::shared_ptr<const LoggingCallbacks> GetCallbacks()
     {
-        static LoggingCallbacks callbacks;
-        return callbacks;
+        return get_callbacks().load(std::memory_order_acquire);
     }
 
+    // Hooks are rare, so they copy the whole table and publish the copy. Logging then never
+    // has to lock or copy anything
     static void HookCallback(const std::string& group,
                              std::function<void(const std::string&)> callback)
     {
-        GetCallbacks()[group].push_back(callback);
+        std::lock_guard<std::mutex> lock(get_mutex());
+        auto callbacks = std::make_shared<LoggingCallbacks>(*GetCallbacks());
+        (*callbacks)[group].push_back(callback);
+        get_callbacks().store(std::move(callbacks), std::memory_order_release);
     }
 
 private:
+    // The RSP and RDP may log from their own threads. Callbacks may log themselves or never
+    // return (the fatal handler exits), so nothing is held locked while they run
     static inline void log_impl(const std::string& group, const std::string& message)
     {
-        std::vector<std::function<void(const std::string&)>>& callbacks = GetCallbacks()[group];
-        for (auto& callback : callbacks)
+        std::shared_ptr<const LoggingCallbacks> callbacks = GetCallbacks();
+        auto it = callbacks->find(group);
+        if (it == callbacks->end())
+        {
+            return;
+        }
+        for (auto& callback : it->second)
         {
             callback(message + "\n");
         }
     }
 
+    static bool has_callbacks(const std::string& group)
+    {
+        std::shared_ptr<const LoggingCallbacks> callbacks = GetCallbacks();
+        auto it = callbacks->find(group);
+        return it != callbacks->end() && !it->second.empty();
+    }
+
+    static std::atomic<std::shared_ptr<const LoggingCallbacks>>& get_callbacks()
+    {
+        static std::atomic<std::shared_ptr<const LoggingCallbacks>> callbacks =
+            std::make_shared<const LoggingCallbacks>();
+        return callbacks;
+    }
+
     static std::unordered_map<uint32_t, bool>& get_warnings()
     {
         static std::unordered_map<uint32_t, bool> warnings;
         return warnings;
     }
+
+    static std::mutex& get_mutex()
+    {
+        static std::mutex mutex;
+        return mutex;
+    }
 };
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace hydra
+{
+    // Keeps a history of save states for rewinding. Only the newest state is kept whole, every
+    // older one is stored as the XOR of itself and the state after it, with the zero runs
+    // compressed away. Consecutive states differ in few bytes so these deltas are small. Deltas
+    // are built on a worker thread and the oldest ones are dropped once the memory used goes over
+    // the budget
+    class Rewinder final
+    {
+    public:
+        Rewinder(size_t budget);
+        ~Rewinder();
+        Rewinder(const Rewinder&) = delete;
+        Rewinder& operator=(const Rewinder&) = delete;
+
+        // Takes the contents of state and gives back a spare buffer in its place, so the caller
+        // can keep saving into it without allocating. If the worker hasn't caught up with the
+        // previous state yet that one is replaced
+        void Push(std::vector<uint8_t>& state);
+
+        // Replaces state with the newest state and removes it from the history. Returns false if
+        // the history is empty
+        bool Pop(std::vector<uint8_t>& state);
+
+        void Clear();
+
+        // Drops the oldest states right away if the history is already over the new budget
+        void SetBudget(size_t budget);
+
+    private:
+        struct Delta
+        {
+            std::vector<uint8_t> data;
+            // Size of the state this delta turns the next state back into
+            size_t size;
+        };
+
+        void worker_loop();
+        void wait_idle(std::unique_lock<std::mutex>& lock);
+        void evict();
+
+        static void encode(const std::vector<uint8_t>& prev, const std::vector<uint8_t>& next,
+                           std::vector<uint8_t>& out);
+        static void apply(std::vector<uint8_t>& state, const Delta& delta);
+
+        std::mutex mutex_;
+        std::condition_variable worker_cv_;
+        std::condition_variable idle_cv_;
+        std::thread worker_;
+        // Only touched by the worker while busy_ is set, or by anyone else holding the lock while
+        // it's idle
+        std::vector<uint8_t> latest_;
+        std::vector<uint8_t> pending_;
+        std::vector<uint8_t> work_;
+        std::deque<Delta> deltas_;
+        size_t deltas_size_ = 0;
+        size_t budget_;
+        bool has_pending_ = false;
+        bool busy_ = false;
+        bool quit_ = false;
+    };
+} // namespace hydra
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+namespace hydra
+{
+    // Save states are flat dumps of every component's fields in host byte order, written in a
+    // fixed order after a header holding the core's magic and the version of its layout. States
+    // with a different magic or version are rejected rather than migrated.
+    struct StateHeader
+    {
+        uint32_t magic;
+        uint32_t version;
+    };
+
+    class StateWriter final
+    {
+    public:
+        // Replaces the contents of buffer. Its capacity is reused, so saving into the same buffer
+        // again doesn't allocate
+        StateWriter(std::vector<uint8_t>& buffer, uint32_t magic, uint32_t version)
+            : buffer_(buffer)
+        {
+            buffer_.clear();
+            Write(StateHeader{magic, version});
+        }
+
+        void Write(const void* data, size_t size)
+        {
+            size_t offset = buffer_.size();
+            buffer_.resize(offset + size);
+            memcpy(buffer_.data() + offset, data, size);
+        }
+
+        template <class T>
+        requires std::is_trivially_copyable_v<T>
+        void Write(const T& value)
+        {
+            Write(&value, sizeof(T));
+        }
+
+    private:
+        std::vector<uint8_t>& buffer_;
+    };
+
+    class StateReader final
+    {
+    public:
+        StateReader(std::span<const uint8_t> data, uint32_t magic, uint32_t version) : data_(data)
+        {
+            StateHeader header{};
+            Read(header);
+            good_ = good_ && header.magic == magic && header.version == version;
+        }
+
+        // Reads past the end leave the destination untouched and make the reader fail
+        void Read(void* data, size_t size)
+        {
+            if (!good_ || data_.size() - offset_ < size)
+            {
+                good_ = false;
+                return;
+            }
+            std::memcpy(data, data_.data() + offset_, size);
+            offset_ += size;
+        }
+
+        template <class T>
+        requires std::is_trivially_copyable_v<T>
+        void Read(T& value)
+        {
+            Read(&value, sizeof(T));
+        }
+
+        // For components that read values that can't be valid
+        void Fail()
+        {
+            good_ = false;
+        }
+
+        // Whether the header matched and every read so far was in bounds
+        bool Good() const
+        {
+            return good_;
+        }
+
+        bool AtEnd() const
+        {
+            return offset_ == data_.size();
+        }
+
+    private:
+        std::span<const uint8_t> data_;
+        size_t offset_ = 0;
+        bool good_ = true;
+    };
+} // namespace hydra
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace hydra
+{
+    // Hands values from one producer thread to one consumer thread without either waiting. The
+    // producer fills Back() and publishes it, the consumer picks up the newest published value
+    // into Front(). Values published while the consumer isn't looking are overwritten
+    template <class T>
+    class TripleBuffer final
+    {
+    public:
+        T& Back()
+        {
+            return buffers_[back_];
+        }
+
+        void Publish()
+        {
+            back_ = middle_.exchange(back_ | DIRTY, std::memory_order_acq_rel) & INDEX;
+        }
+
+        // Returns false if nothing new was published since the last call
+        bool Consume()
+        {
+            if (!(middle_.load(std::memory_order_relaxed) & DIRTY))
+            {
+                return false;
+            }
+            front_ = middle_.exchange(front_, std::memory_order_acq_rel) & INDEX;
+            return true;
+        }
+
+        T& Front()
+        {
+            return buffers_[front_];
+        }
+
+    private:
+        static constexpr uint8_t INDEX = 0b11;
+        static constexpr uint8_t DIRTY = 0b100;
+
+        std::array<T, 3> buffers_{};
+        uint8_t back_ = 0;
+        std::atomic<uint8_t> middle_ = 1;
+        uint8_t front_ = 2;
+    };
+} // namespace hydra
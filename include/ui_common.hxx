@@ -13,6 +13,7 @@ namespace hydra
         std::vector<std::string> Extensions;
     };
     class Core;
+    struct VideoInfo;
 
     class UiCommon
     {
@@ -20,6 +21,8 @@ namespace hydra
         static std::string GetSavePath();
         static std::unique_ptr<Core> Create(EmuType type);
         static hydra::EmuType GetEmulatorType(const std::filesystem::path& path);
+        // Copies frame into out as tightly packed RGBA8888, whatever its format
+        static void ConvertToRGBA8888(const VideoInfo& frame, std::vector<uint8_t>& out);
         static std::array<emulator_data_t, EmuTypeSize> EmulatorData;
     };
 } // namespace hydra
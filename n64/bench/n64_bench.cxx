@@ -0,0 +1,199 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <json.hpp>
+#include <log.hxx>
+#include <memory>
+#include <n64/core/n64_impl.hxx>
+#include <n64/core/n64_profiler.hxx>
+#include <string>
+#include <vector>
+
+#if defined(_WIN32)
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+// Runs a ROM headless as fast as possible and prints throughput numbers as JSON, so performance
+// changes can be measured without the frontend's 60Hz timer getting in the way
+
+namespace
+{
+    void print_usage(const char* name)
+    {
+        std::fprintf(stderr,
+                     "Usage: %s <ipl> <rom> [--frames N] [--warmup N] [--rsp-thread] "
+                     "[--rdp-thread] [--no-fastmem] [--frameskip N] [--trace FILE]\n",
+                     name);
+    }
+
+    uint64_t peak_rss_bytes()
+    {
+#if defined(_WIN32)
+        PROCESS_MEMORY_COUNTERS counters{};
+        GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters));
+        return counters.PeakWorkingSetSize;
+#else
+        rusage usage{};
+        getrusage(RUSAGE_SELF, &usage);
+#if defined(__APPLE__)
+        return usage.ru_maxrss;
+#else
+        return static_cast<uint64_t>(usage.ru_maxrss) * 1024;
+#endif
+#endif
+    }
+} // namespace
+
+int main(int argc, char** argv)
+{
+    if (argc < 3)
+    {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    std::string ipl_path = argv[1];
+    std::string rom_path = argv[2];
+    int frames = 600;
+    int warmup = 60;
+    bool rsp_thread = false;
+    bool rdp_thread = false;
+    bool fastmem = true;
+    int frameskip = 0;
+    std::string trace_path;
+    for (int i = 3; i < argc; i++)
+    {
+        if (std::strcmp(argv[i], "--frames") == 0 && i + 1 < argc)
+        {
+            frames = std::max(1, std::atoi(argv[++i]));
+        }
+        else if (std::strcmp(argv[i], "--warmup") == 0 && i + 1 < argc)
+        {
+            warmup = std::max(0, std::atoi(argv[++i]));
+        }
+        else if (std::strcmp(argv[i], "--rsp-thread") == 0)
+        {
+            rsp_thread = true;
+        }
+        else if (std::strcmp(argv[i], "--rdp-thread") == 0)
+        {
+            rdp_thread = true;
+        }
+        else if (std::strcmp(argv[i], "--no-fastmem") == 0)
+        {
+            fastmem = false;
+        }
+        else if (std::strcmp(argv[i], "--frameskip") == 0 && i + 1 < argc)
+        {
+            frameskip = std::max(0, std::atoi(argv[++i]));
+        }
+        else if (std::strcmp(argv[i], "--trace") == 0 && i + 1 < argc)
+        {
+            trace_path = argv[++i];
+        }
+        else
+        {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    Logger::HookCallback("Fatal", [](const std::string& message) {
+        std::fprintf(stderr, "Fatal: %s", message.c_str());
+        std::exit(1);
+    });
+
+    auto emulator = std::make_unique<hydra::N64::N64>();
+    emulator->SetAudioCallback([](const std::vector<int16_t>&, int) {});
+    emulator->SetPollInputCallback([]() {});
+    emulator->SetReadInputCallback([](int, int, int) -> int8_t { return 0; });
+    emulator->SetRSPThreaded(rsp_thread);
+    emulator->SetRDPThreaded(rdp_thread);
+    emulator->SetFastmem(fastmem);
+    if (!emulator->LoadIPL(ipl_path))
+    {
+        std::fprintf(stderr, "Failed to load IPL: %s\n", ipl_path.c_str());
+        return 1;
+    }
+    if (!emulator->LoadCartridge(rom_path))
+    {
+        std::fprintf(stderr, "Failed to load ROM: %s\n", rom_path.c_str());
+        return 1;
+    }
+
+    // Rendering is part of a frame's cost even if nobody looks at the result
+    std::vector<uint8_t> screen;
+    for (int i = 0; i < warmup; i++)
+    {
+        emulator->RunFrame();
+        emulator->RenderVideo(screen);
+    }
+
+#ifdef HYDRA_N64_PROFILER
+    hydra::N64::Profiler::Clear();
+#endif
+    hydra::N64::PerfStats before = emulator->GetPerfStats();
+    emulator->SetFrameskip(frameskip);
+    int repeated_frames = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < frames; i++)
+    {
+        emulator->RunFrame();
+        if (!emulator->IsFrameSkipped())
+        {
+            repeated_frames += emulator->RenderVideo(screen) == 0;
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+    hydra::N64::PerfStats after = emulator->GetPerfStats();
+
+    double seconds = std::chrono::duration<double>(end - start).count();
+    uint64_t cpu_instructions = after.cpu_cycles - before.cpu_cycles;
+    uint64_t rsp_instructions = after.rsp_instructions - before.rsp_instructions;
+    double rsp_seconds = (after.rsp_time - before.rsp_time) / 1e9;
+    double rdp_seconds = (after.rdp_time - before.rdp_time) / 1e9;
+
+    nlohmann::ordered_json result;
+    result["rom"] = rom_path;
+    result["frames"] = frames;
+    result["warmup_frames"] = warmup;
+    result["rsp_thread"] = rsp_thread;
+    result["rdp_thread"] = rdp_thread;
+    result["frameskip"] = frameskip;
+#ifdef HYDRA_N64_JIT
+    result["cpu_backend"] = "jit";
+    result["fastmem"] = fastmem;
+#else
+    result["cpu_backend"] = "interpreter";
+#endif
+    result["seconds"] = seconds;
+    result["fps"] = frames / seconds;
+    result["repeated_frames"] = repeated_frames;
+    // The CPU retires an instruction per cycle as far as the core is concerned
+    result["cpu_instructions"] = cpu_instructions;
+    result["mips"] = cpu_instructions / seconds / 1e6;
+    result["rsp_instructions"] = rsp_instructions;
+    result["rsp_mips"] = rsp_instructions / seconds / 1e6;
+    // Busy time on whichever thread did the work, so with threading enabled the shares can add
+    // up to more than 1
+    result["rsp_seconds"] = rsp_seconds;
+    result["rdp_seconds"] = rdp_seconds;
+    result["rsp_share"] = rsp_seconds / seconds;
+    result["rdp_share"] = rdp_seconds / seconds;
+    result["peak_rss_bytes"] = peak_rss_bytes();
+    if (!trace_path.empty())
+    {
+#ifdef HYDRA_N64_PROFILER
+        result["trace"] = hydra::N64::Profiler::WriteChromeTrace(trace_path) ? trace_path : "";
+#else
+        std::fprintf(stderr, "--trace needs a build with HYDRA_N64_PROFILER\n");
+#endif
+    }
+    std::printf("%s\n", result.dump(4).c_str());
+    return 0;
+}
@@ -17,6 +17,10 @@ addr RSP_PC = 0x0408'0000;
 addr RSP_AREA_START = 0x0404'0000;
 addr RSP_AREA_END = 0x040F'FFFF;
 
+addr RSP_DMEM_START = 0x0400'0000;
+addr RSP_IMEM_START = 0x0400'1000;
+addr RSP_IMEM_END = 0x0400'1FFF;
+
 // RDP command registers
 addr DP_START = 0x0410'0000;
 addr DP_END = 0x0410'0004;
@@ -113,6 +117,10 @@ addr RDRAM_REGISTERS_END = 0x03F7'FFFF;
 addr RDRAM_BROADCAST_START = 0x03F8'0000;
 addr RDRAM_BROADCAST_END = 0x03FF'FFFF;
 
+// Cartridge domain 1 address 2
+addr CART_ROM_START = 0x1000'0000;
+addr CART_ROM_END = 0x1FBF'FFFF;
+
 // ISVIEWER
 addr ISVIEWER_FLUSH = 0x13FF'0014;
 addr ISVIEWER_AREA_START = 0x13FF'0020;
@@ -5,6 +5,7 @@
 #include <miniaudio.h>
 #include <n64/core/n64_addresses.hxx>
 #include <n64/core/n64_ai.hxx>
+#include <n64/core/n64_profiler.hxx>
 
 namespace hydra::N64
 {
@@ -13,6 +14,26 @@ namespace hydra::N64
         ai_dma_count_ = 0;
     }
 
+    void Ai::SaveState(StateWriter& writer) const
+    {
+        writer.Write(ai_frequency_);
+        writer.Write(ai_period_);
+        writer.Write(ai_enabled_);
+        writer.Write(ai_dma_count_);
+        writer.Write(ai_dma_addresses_);
+        writer.Write(ai_dma_lengths_);
+    }
+
+    void Ai::LoadState(StateReader& reader)
+    {
+        reader.Read(ai_frequency_);
+        reader.Read(ai_period_);
+        reader.Read(ai_enabled_);
+        reader.Read(ai_dma_count_);
+        reader.Read(ai_dma_addresses_);
+        reader.Read(ai_dma_lengths_);
+    }
+
     void Ai::WriteWord(uint32_t addr, uint32_t data)
     {
         switch (addr)
@@ -37,6 +58,7 @@ namespace hydra::N64
                 if (ai_dma_count_ < 2 && length != 0)
                 {
                     ai_dma_lengths_[ai_dma_count_] = length;
+                    N64_PROFILE_COUNT(AiDmaBytes, length);
                     ai_dma_count_++;
                 }
                 break;
@@ -103,41 +125,37 @@ namespace hydra::N64
         }
     }
 
+    // Called by the scheduler once every ai_period_ cycles
     void Ai::Step()
     {
-        ai_cycles_++;
-        while (ai_cycles_ > ai_period_)
+        if (ai_dma_count_ == 0)
         {
-            ai_cycles_ -= ai_period_;
-            if (ai_dma_count_ == 0)
-            {
-                return;
-            }
-            uint32_t address = ai_dma_addresses_[0];
-            address &= 0x7ff'ffff;
-            uint32_t data = *reinterpret_cast<uint32_t*>(rdram_ptr_ + address);
-            int16_t left = (static_cast<int16_t>(data >> 16));
-            int16_t right = (static_cast<int16_t>(data & 0xffff));
-            ai_buffer_.push_back(bswap16(left));
-            ai_buffer_.push_back(bswap16(right));
-            if (ai_buffer_.size() > 200000)
-            {
-                Logger::Fatal("AI buffer overflow");
-            }
-            ai_dma_addresses_[0] += 4;
-            ai_dma_lengths_[0] -= 4;
-            if (ai_dma_lengths_[0] == 0)
+            return;
+        }
+        uint32_t address = ai_dma_addresses_[0];
+        address &= 0x7ff'ffff;
+        uint32_t data = *reinterpret_cast<uint32_t*>(rdram_ptr_ + address);
+        int16_t left = (static_cast<int16_t>(data >> 16));
+        int16_t right = (static_cast<int16_t>(data & 0xffff));
+        ai_buffer_.push_back(bswap16(left));
+        ai_buffer_.push_back(bswap16(right));
+        if (ai_buffer_.size() > 200000)
+        {
+            Logger::Fatal("AI buffer overflow");
+        }
+        ai_dma_addresses_[0] += 4;
+        ai_dma_lengths_[0] -= 4;
+        if (ai_dma_lengths_[0] == 0)
+        {
+            interrupt_callback_(true);
+            ai_dma_count_--;
+            if (ai_dma_count_ > 0)
             {
-                interrupt_callback_(true);
-                ai_dma_count_--;
-                if (ai_dma_count_ > 0)
-                {
-                    ai_dma_addresses_[0] = ai_dma_addresses_[1];
-                    ai_dma_lengths_[0] = ai_dma_lengths_[1];
-                }
-                audio_callback_(ai_buffer_, ai_frequency_);
-                ai_buffer_.clear();
+                ai_dma_addresses_[0] = ai_dma_addresses_[1];
+                ai_dma_lengths_[0] = ai_dma_lengths_[1];
             }
+            audio_callback_(ai_buffer_, ai_frequency_);
+            ai_buffer_.clear();
         }
     }
 
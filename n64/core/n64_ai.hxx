@@ -6,6 +6,7 @@
 #include <functional>
 #include <log.hxx>
 #include <n64/core/n64_types.hxx>
+#include <state.hxx>
 #include <vector>
 
 namespace hydra::N64
@@ -21,6 +22,8 @@ namespace hydra::N64
     {
     public:
         void Reset();
+        void SaveState(StateWriter& writer) const;
+        void LoadState(StateReader& reader);
         void InstallBuses(uint8_t* rdram_ptr);
         void SetInterruptCallback(std::function<void(bool)> callback);
         void SetAudioCallback(
@@ -34,7 +37,6 @@ namespace hydra::N64
         uint32_t ai_period_ = 93750000 / 48000;
         bool ai_enabled_ = false;
         uint8_t ai_dma_count_ = 0;
-        uint32_t ai_cycles_ = 0;
         std::function<void(bool)> interrupt_callback_;
         std::function<void(const std::vector<int16_t>&, int)> audio_callback_;
 
@@ -4,12 +4,15 @@
 #include <cmath>
 #include <compatibility.hxx>
 #include <cstring>
+#include <filesystem>
 #include <fstream>
 #include <functional>
 #include <iomanip>
 #include <iostream>
 #include <limits>
 #include <n64/core/n64_cpu.hxx>
+#include <n64/core/n64_cpu_jit.hxx>
+#include <n64/core/n64_profiler.hxx>
 #include <random>
 #include <sstream>
 
@@ -21,30 +24,104 @@ namespace hydra::N64
 
     CPUBus::CPUBus(RCP& rcp) : rcp_(rcp)
     {
-        cart_rom_.resize(0xFC00000);
-        rdram_.resize(0x800000);
+        reset_cartridge_domain();
+        rdram_ = {fastmem_.Commit(0, 0x800000), 0x800000};
         map_direct_addresses();
     }
 
     bool CPUBus::LoadCartridge(std::string path)
     {
-        std::ifstream ifs(path, std::ios::in | std::ios::binary);
-        if (ifs.is_open())
+        std::error_code error;
+        size_t size = std::filesystem::file_size(path, error);
+        if (error)
         {
-            ifs.unsetf(std::ios::skipws);
-            ifs.seekg(0, std::ios::end);
-            std::streampos size = ifs.tellg();
-            ifs.seekg(0, std::ios::beg);
-            ifs.read(reinterpret_cast<char*>(cart_rom_.data()), size);
-            rom_loaded_ = true;
+            return false;
+        }
+
+        if (size > cart_rom_.size())
+        {
+            Logger::Warn("Cartridge is larger than the cartridge domain, truncating");
+            size = cart_rom_.size();
+        }
+
+        reset_cartridge_domain();
+        if (fastmem_.MapFile(CART_ROM_START, path, size))
+        {
+            fastmem_.Decommit(ISVIEWER_FLUSH & ~0xFFFFu, 0x10000);
         }
         else
         {
-            return false;
+            reset_cartridge_domain();
+            std::ifstream ifs(path, std::ios::in | std::ios::binary);
+            if (!ifs.is_open())
+            {
+                return false;
+            }
+            ifs.read(reinterpret_cast<char*>(cart_rom_.data()), size);
         }
+        normalize_cartridge_byte_order(size);
+        rom_loaded_ = true;
         return true;
     }
 
+    void CPUBus::reset_cartridge_domain()
+    {
+        // Untouched pages don't take up any memory, so only the pages of the cartridge that get
+        // accessed end up resident
+        cart_rom_ = {fastmem_.Commit(CART_ROM_START, CART_ROM_END - CART_ROM_START + 1),
+                     CART_ROM_END - CART_ROM_START + 1};
+        // The ISViewer registers are emulated, keep them out of reach of fastmem accesses
+        fastmem_.Decommit(ISVIEWER_FLUSH & ~0xFFFFu, 0x10000);
+    }
+
+    void CPUBus::normalize_cartridge_byte_order(size_t size)
+    {
+        if (size < 4)
+        {
+            return;
+        }
+
+        uint32_t magic;
+        std::memcpy(&magic, cart_rom_.data(), sizeof(uint32_t));
+        switch (hydra::bswap32(magic))
+        {
+            // .z64, already big endian
+            case 0x8037'1240:
+            {
+                break;
+            }
+            // .v64, every halfword is byteswapped
+            case 0x3780'4012:
+            {
+                for (size_t i = 0; i + 2 <= size; i += 2)
+                {
+                    uint16_t data;
+                    std::memcpy(&data, &cart_rom_[i], sizeof(uint16_t));
+                    data = hydra::bswap16(data);
+                    std::memcpy(&cart_rom_[i], &data, sizeof(uint16_t));
+                }
+                break;
+            }
+            // .n64, every word is little endian
+            case 0x4012'3780:
+            {
+                for (size_t i = 0; i + 4 <= size; i += 4)
+                {
+                    uint32_t data;
+                    std::memcpy(&data, &cart_rom_[i], sizeof(uint32_t));
+                    data = hydra::bswap32(data);
+                    std::memcpy(&cart_rom_[i], &data, sizeof(uint32_t));
+                }
+                break;
+            }
+            default:
+            {
+                Logger::Warn("Unknown cartridge byte order: {:08X}", hydra::bswap32(magic));
+                break;
+            }
+        }
+    }
+
     bool CPUBus::LoadIPL(std::string path)
     {
         std::ifstream ifs(path, std::ios::in | std::ios::binary);
@@ -115,19 +192,78 @@ namespace hydra::N64
         pif_ram_[0x27] = 0x3F;
     }
 
-    uint8_t* CPUBus::redirect_paddress(uint32_t paddr)
-    {
-        uint8_t* ptr = page_table_[paddr >> 16];
-        if (ptr) [[likely]]
-        {
-            ptr += (paddr & static_cast<uint32_t>(0xFFFF));
-            return ptr;
-        }
-        else if (paddr - 0x1FC00000u < 1984u)
-        {
-            return &ipl_[paddr - 0x1FC00000u];
-        }
-        return nullptr;
+    void CPUBus::SaveState(StateWriter& writer) const
+    {
+        writer.Write(rdram_.data(), rdram_.size());
+        writer.Write(pif_ram_);
+        writer.Write(mi_mode_);
+        writer.Write(mi_version_);
+        writer.Write(mi_interrupt_);
+        writer.Write(mi_mask_);
+        writer.Write(pi_dram_addr_);
+        writer.Write(pi_cart_addr_);
+        writer.Write(pi_rd_len_);
+        writer.Write(pi_wr_len_);
+        writer.Write(pi_status_);
+        writer.Write(dma_error_);
+        writer.Write(io_busy_);
+        writer.Write(dma_busy_);
+        writer.Write(pi_bsd_dom1_lat_);
+        writer.Write(pi_bsd_dom1_pwd_);
+        writer.Write(pi_bsd_dom1_pgs_);
+        writer.Write(pi_bsd_dom1_rls_);
+        writer.Write(pi_bsd_dom2_lat_);
+        writer.Write(pi_bsd_dom2_pwd_);
+        writer.Write(pi_bsd_dom2_pgs_);
+        writer.Write(pi_bsd_dom2_rls_);
+        writer.Write(ri_mode_);
+        writer.Write(ri_config_);
+        writer.Write(ri_current_load_);
+        writer.Write(ri_select_);
+        writer.Write(ri_refresh_);
+        writer.Write(ri_latency_);
+        writer.Write(si_dram_addr_);
+        writer.Write(si_pif_ad_wr64b_);
+        writer.Write(si_pif_ad_rd64b_);
+        writer.Write(si_status_);
+        writer.Write(time_);
+    }
+
+    void CPUBus::LoadState(StateReader& reader)
+    {
+        reader.Read(rdram_.data(), rdram_.size());
+        reader.Read(pif_ram_);
+        reader.Read(mi_mode_);
+        reader.Read(mi_version_);
+        reader.Read(mi_interrupt_);
+        reader.Read(mi_mask_);
+        reader.Read(pi_dram_addr_);
+        reader.Read(pi_cart_addr_);
+        reader.Read(pi_rd_len_);
+        reader.Read(pi_wr_len_);
+        reader.Read(pi_status_);
+        reader.Read(dma_error_);
+        reader.Read(io_busy_);
+        reader.Read(dma_busy_);
+        reader.Read(pi_bsd_dom1_lat_);
+        reader.Read(pi_bsd_dom1_pwd_);
+        reader.Read(pi_bsd_dom1_pgs_);
+        reader.Read(pi_bsd_dom1_rls_);
+        reader.Read(pi_bsd_dom2_lat_);
+        reader.Read(pi_bsd_dom2_pwd_);
+        reader.Read(pi_bsd_dom2_pgs_);
+        reader.Read(pi_bsd_dom2_rls_);
+        reader.Read(ri_mode_);
+        reader.Read(ri_config_);
+        reader.Read(ri_current_load_);
+        reader.Read(ri_select_);
+        reader.Read(ri_refresh_);
+        reader.Read(ri_latency_);
+        reader.Read(si_dram_addr_);
+        reader.Read(si_pif_ad_wr64b_);
+        reader.Read(si_pif_ad_rd64b_);
+        reader.Read(si_status_);
+        reader.Read(time_);
     }
 
     void CPUBus::map_direct_addresses()
@@ -148,9 +284,9 @@ namespace hydra::N64
         }
 
         // Map cartridge rom
-        for (int i = ADDR_TO_PAGE(0x1000'0000); i <= ADDR_TO_PAGE(0x1FBF'0000); i++)
+        for (uint32_t i = ADDR_TO_PAGE(CART_ROM_START); i <= ADDR_TO_PAGE(CART_ROM_END); i++)
         {
-            page_table_[i] = &cart_rom_[PAGE_SIZE * (i - ADDR_TO_PAGE(0x1000'0000))];
+            page_table_[i] = &cart_rom_[PAGE_SIZE * (i - ADDR_TO_PAGE(CART_ROM_START))];
         }
         page_table_[ADDR_TO_PAGE(ISVIEWER_AREA_START)] = nullptr;
 #undef ADDR_TO_PAGE
@@ -245,6 +381,14 @@ namespace hydra::N64
 
     void CPU::write_hwio(uint32_t addr, uint32_t data)
     {
+        // A threaded RSP writes the DPC registers itself and runs the RDP's command processing
+        // on its worker, wait for it before touching either
+        if ((addr >= RSP_AREA_START && addr <= RSP_AREA_END) ||
+            (addr >= RDP_AREA_START && addr <= RDP_AREA_END))
+        {
+            rcp_.rsp_.Sync();
+        }
+
         // TODO: remove switch, turn into if chain
         switch (addr)
         {
@@ -286,23 +430,15 @@ namespace hydra::N64
                     set_interrupt(InterruptType::PI, true);
                     return;
                 }
+                rcp_.rdp_.FlushIfPending(dram_addr, length, true);
                 std::memcpy(&cpubus_.rdram_[dram_addr], cpubus_.redirect_paddress(cart_addr),
                             length);
+                invalidate_code(dram_addr, length);
+                N64_PROFILE_COUNT(PiDmaBytes, length);
                 cpubus_.dma_busy_ = true;
-                // uint8_t domain = 0;
-                // if ((cart_addr >= 0x0800'0000 && cart_addr < 0x1000'0000) ||
-                //     (cart_addr >= 0x0500'0000 && cart_addr < 0x0600'0000))
-                // {
-                //     domain = 2;
-                // } else if ((cart_addr >= 0x0600'0000 && cart_addr < 0x0800'0000) ||
-                //            (cart_addr >= 0x1000'0000 && cart_addr < 0x1FC0'0000))
-                // {
-                //     domain = 1;
-                // }
-                // auto cycles = timing_pi_access(domain, length);
-                cpubus_.dma_busy_ = false;
-                set_interrupt(InterruptType::PI, true);
-                Logger::Debug("Raising PI interrupt");
+                // SRAM is handled above, so the only domain 2 device left is the 64DD
+                uint8_t domain = (cart_addr >= 0x0500'0000 && cart_addr < 0x0600'0000) ? 2 : 1;
+                scheduler_.Schedule(SchedulerEventType::PI, timing_pi_access(domain, length));
                 return;
             }
             case PI_BSD_DOM1_PWD:
@@ -384,20 +520,23 @@ namespace hydra::N64
             }
             case SI_PIF_AD_WR64B:
             {
+                rcp_.rdp_.FlushIfPending(cpubus_.si_dram_addr_ & 0xff'ffff, 64, false);
                 std::memcpy(cpubus_.pif_ram_.data(),
                             &cpubus_.rdram_[cpubus_.si_dram_addr_ & 0xff'ffff], 64);
                 pif_command();
-                set_interrupt(InterruptType::SI, true);
-                Logger::Debug("Raising SI interrupt");
+                N64_PROFILE_COUNT(SiDmaBytes, 64);
+                scheduler_.Schedule(SchedulerEventType::SI, SI_DMA_CYCLES);
                 return;
             }
             case SI_PIF_AD_RD64B:
             {
                 pif_command();
+                rcp_.rdp_.FlushIfPending(cpubus_.si_dram_addr_ & 0xff'ffff, 64, true);
                 std::memcpy(&cpubus_.rdram_[cpubus_.si_dram_addr_ & 0xff'ffff],
                             cpubus_.pif_ram_.data(), 64);
-                set_interrupt(InterruptType::SI, true);
-                Logger::Debug("Raising SI interrupt");
+                invalidate_code(cpubus_.si_dram_addr_ & 0xff'ffff, 64);
+                N64_PROFILE_COUNT(SiDmaBytes, 64);
+                scheduler_.Schedule(SchedulerEventType::SI, SI_DMA_CYCLES);
                 return;
             }
             case SI_STATUS:
@@ -433,8 +572,15 @@ namespace hydra::N64
                     rcp_.rsp_.write_hwio(RSPHWIO::WrLen, data);
                     break;
                 case RSP_STATUS:
+                {
+                    bool was_halted = rcp_.rsp_.IsHalted();
                     rcp_.rsp_.write_hwio(RSPHWIO::Status, data);
+                    if (was_halted && !rcp_.rsp_.IsHalted())
+                    {
+                        scheduler_.Schedule(SchedulerEventType::RSP, 0);
+                    }
                     break;
+                }
                 case RSP_SEMAPHORE:
                     rcp_.rsp_.write_hwio(RSPHWIO::Semaphore, data);
                     break;
@@ -503,6 +649,13 @@ namespace hydra::N64
 
     uint32_t CPU::read_hwio(uint32_t addr)
     {
+        // See write_hwio
+        if ((addr >= RSP_AREA_START && addr <= RSP_AREA_END) ||
+            (addr >= RDP_AREA_START && addr <= RDP_AREA_END))
+        {
+            rcp_.rsp_.Sync();
+        }
+
 #define redir_case(addr, data) \
     case addr:                 \
         return data;
@@ -838,23 +991,37 @@ namespace hydra::N64
         }
     }
 
-    CPU::CPU(CPUBus& cpubus, RCP& rcp)
+    CPU::CPU(CPUBus& cpubus, RCP& rcp, Scheduler& scheduler)
         : gpr_regs_{}, fpr_regs_{}, instr_cache_(KB(16)), data_cache_(KB(8)), cpubus_(cpubus),
-          rcp_(rcp)
+          rcp_(rcp), scheduler_(scheduler)
     {
         rcp_.ai_.InstallBuses(&cpubus_.rdram_[0]);
         rcp_.vi_.InstallBuses(&cpubus_.rdram_[0]);
         rcp_.rsp_.InstallBuses(&cpubus_.rdram_[0], &rcp_.rdp_);
-        rcp_.rdp_.InstallBuses(&cpubus_.rdram_[0], &rcp_.rsp_.mem_[0]);
+        rcp_.rdp_.InstallBuses(&cpubus_.rdram_[0], &rcp_.rsp_.mem_[0], &rcp_.vi_);
         rcp_.ai_.SetInterruptCallback(
             std::bind(&CPU::set_interrupt, this, InterruptType::AI, std::placeholders::_1));
         rcp_.vi_.SetInterruptCallback(
             std::bind(&CPU::set_interrupt, this, InterruptType::VI, std::placeholders::_1));
         rcp_.rsp_.SetInterruptCallback(
             std::bind(&CPU::set_interrupt, this, InterruptType::SP, std::placeholders::_1));
-        rcp_.rdp_.SetInterruptCallback(
-            std::bind(&CPU::set_interrupt, this, InterruptType::DP, std::placeholders::_1));
-    }
+        // The RDP may be driven by a threaded RSP, so its interrupts go through the RSP's queue
+        rcp_.rdp_.SetInterruptCallback([this](bool value) {
+            rcp_.rsp_.post_callback([this, value] { set_interrupt(InterruptType::DP, value); });
+        });
+        rcp_.rsp_.SetRDRAMWriteCallback(std::bind(&CPU::invalidate_code, this,
+                                                  std::placeholders::_1, std::placeholders::_2));
+        scheduler_.SetEventCallback(SchedulerEventType::Compare,
+                                    std::bind(&CPU::compare_event, this));
+        scheduler_.SetEventCallback(SchedulerEventType::PI, std::bind(&CPU::pi_dma_event, this));
+        scheduler_.SetEventCallback(SchedulerEventType::SI, std::bind(&CPU::si_dma_event, this));
+        decoded_pages_.resize(0x1FC0'0000 >> DECODED_PAGE_SHIFT);
+#ifdef HYDRA_N64_JIT
+        jit_ = std::make_unique<CPUJit>(*this);
+#endif
+    }
+
+    CPU::~CPU() = default;
 
     void CPU::Reset()
     {
@@ -889,9 +1056,80 @@ namespace hydra::N64
             newentry.initialized = false;
             std::swap(entry, newentry);
         }
+        invalidate_tlb_cache();
         store_word(
             0x8000'0318,
             0x800000); // TODO: probably done by pif somewhere if RI_SELECT is emulated or something
+        schedule_compare_event();
+        invalidate_all_code();
+    }
+
+    void CPU::SaveState(StateWriter& writer) const
+    {
+        writer.Write(gpr_regs_);
+        writer.Write(fpr_regs_);
+        writer.Write(cp0_regs_);
+        writer.Write(tlb_);
+        writer.Write(prev_pc_);
+        writer.Write(pc_);
+        writer.Write(next_pc_);
+        writer.Write(hi_);
+        writer.Write(lo_);
+        writer.Write(llbit_);
+        writer.Write(lladdr_);
+        writer.Write(fcr0_);
+        writer.Write(fcr31_);
+        writer.Write(opmode_);
+        writer.Write(mode64_);
+        writer.Write(cp0_weirdness_);
+        writer.Write(cp2_weirdness_);
+        writer.Write(prev_branch_);
+        writer.Write(was_branch_);
+        writer.Write(tlb_offset_mask_);
+        writer.Write(pif_channel_);
+        writer.Write(should_service_interrupt_);
+    }
+
+    void CPU::LoadState(StateReader& reader)
+    {
+        reader.Read(gpr_regs_);
+        reader.Read(fpr_regs_);
+        reader.Read(cp0_regs_);
+        reader.Read(tlb_);
+        reader.Read(prev_pc_);
+        reader.Read(pc_);
+        reader.Read(next_pc_);
+        reader.Read(hi_);
+        reader.Read(lo_);
+        reader.Read(llbit_);
+        reader.Read(lladdr_);
+        reader.Read(fcr0_);
+        reader.Read(fcr31_);
+        reader.Read(opmode_);
+        reader.Read(mode64_);
+        reader.Read(cp0_weirdness_);
+        reader.Read(cp2_weirdness_);
+        reader.Read(prev_branch_);
+        reader.Read(was_branch_);
+        reader.Read(tlb_offset_mask_);
+        reader.Read(pif_channel_);
+        reader.Read(should_service_interrupt_);
+        // RDRAM and the TLB were replaced wholesale, nothing derived from them can be trusted
+        invalidate_all_code();
+        invalidate_tlb_cache();
+        update_host_round_mode();
+    }
+
+    void CPU::invalidate_all_code()
+    {
+        for (auto& page : decoded_pages_)
+        {
+            page.reset();
+        }
+        decoded_ = &uncached_instruction_;
+#ifdef HYDRA_N64_JIT
+        jit_->Flush();
+#endif
     }
 
     // Shamelessly stolen from dillon
@@ -950,12 +1188,34 @@ namespace hydra::N64
         else if (addr >= 0 && addr <= 0x7FFFFFFF)
         {
             // User segment
+            TLBCacheEntry& entry = tlb_cache_[(addr >> 12) & (TLB_CACHE_SIZE - 1)];
+            uint8_t asid = CP0EntryHi.ASID;
+            uint32_t offset = addr & 0xFFF;
+            if (entry.vpage == (addr >> 12) && entry.generation == tlb_generation_ &&
+                entry.asid == asid) [[likely]]
+            {
+                return {entry.ppage | offset, entry.cached, true,
+                        entry.host ? entry.host + offset : nullptr};
+            }
+
             TranslatedAddress paddr = probe_tlb(addr);
             if (!paddr.success)
             {
                 throw_exception(prev_pc_, ExceptionType::TLBMissLoad);
                 set_cp0_regs_exception(addr);
-            }
+                return paddr;
+            }
+
+            // TLB pages are at least 4KB and aligned to their size, so the whole page translates
+            // the same way
+            uint32_t ppage = paddr.paddr & ~0xFFFu;
+            entry.vpage = addr >> 12;
+            entry.ppage = ppage;
+            entry.host = ppage < cpubus_.rdram_.size() ? &cpubus_.rdram_[ppage] : nullptr;
+            entry.generation = tlb_generation_;
+            entry.asid = asid;
+            entry.cached = paddr.cached;
+            paddr.host = entry.host ? entry.host + offset : nullptr;
             return paddr;
         }
         else if (addr >= 0xC0000000 && addr <= 0xDFFFFFFF)
@@ -999,10 +1259,20 @@ namespace hydra::N64
         return hydra::bswap16(data);
     }
 
+    uint8_t* CPU::redirect_translated(const TranslatedAddress& paddr, bool write)
+    {
+        if (paddr.host)
+        {
+            rcp_.rdp_.FlushIfPending(paddr.paddr, write);
+            return paddr.host;
+        }
+        return cpubus_.redirect_paddress(paddr.paddr, write);
+    }
+
     uint32_t CPU::load_word(uint64_t vaddr)
     {
         TranslatedAddress paddr = translate_vaddr(vaddr);
-        uint8_t* ptr = cpubus_.redirect_paddress(paddr.paddr);
+        uint8_t* ptr = redirect_translated(paddr);
         if (!ptr)
         {
             return read_hwio(paddr.paddr);
@@ -1033,31 +1303,33 @@ namespace hydra::N64
     void CPU::store_byte(uint64_t vaddr, uint8_t data)
     {
         TranslatedAddress paddr = translate_vaddr(vaddr);
-        uint8_t* ptr = cpubus_.redirect_paddress(paddr.paddr);
+        uint8_t* ptr = cpubus_.redirect_paddress(paddr.paddr, true);
         if (!ptr)
         {
             Logger::Warn("Attempted to store byte to invalid address: {:08x}", vaddr);
             return;
         }
         *ptr = data;
+        invalidate_code(paddr.paddr, sizeof(uint8_t));
     }
 
     void CPU::store_halfword(uint64_t vaddr, uint16_t data)
     {
         TranslatedAddress paddr = translate_vaddr(vaddr);
-        uint16_t* ptr = reinterpret_cast<uint16_t*>(cpubus_.redirect_paddress(paddr.paddr));
+        uint16_t* ptr = reinterpret_cast<uint16_t*>(cpubus_.redirect_paddress(paddr.paddr, true));
         if (!ptr)
         {
             Logger::Fatal("Attempted to store halfword to invalid address: {:08x}", vaddr);
         }
         data = hydra::bswap16(data);
         memcpy(ptr, &data, sizeof(uint16_t));
+        invalidate_code(paddr.paddr, sizeof(uint16_t));
     }
 
     void CPU::store_word(uint64_t vaddr, uint32_t data)
     {
         TranslatedAddress paddr = translate_vaddr(vaddr);
-        uint32_t* ptr = reinterpret_cast<uint32_t*>(cpubus_.redirect_paddress(paddr.paddr));
+        uint32_t* ptr = reinterpret_cast<uint32_t*>(redirect_translated(paddr, true));
         bool isviewer = paddr.paddr <= ISVIEWER_AREA_END && paddr.paddr >= ISVIEWER_FLUSH;
         if (!ptr || isviewer)
         {
@@ -1067,36 +1339,142 @@ namespace hydra::N64
         {
             data = hydra::bswap32(data);
             memcpy(ptr, &data, sizeof(uint32_t));
+            invalidate_code(paddr.paddr, sizeof(uint32_t));
         }
     }
 
     void CPU::store_doubleword(uint64_t vaddr, uint64_t data)
     {
         TranslatedAddress paddr = translate_vaddr(vaddr);
-        uint64_t* ptr = reinterpret_cast<uint64_t*>(cpubus_.redirect_paddress(paddr.paddr));
+        uint64_t* ptr = reinterpret_cast<uint64_t*>(cpubus_.redirect_paddress(paddr.paddr, true));
         if (!ptr)
         {
             Logger::Fatal("Attempted to store doubleword to invalid address: {:08x}", vaddr);
         }
         data = hydra::bswap64(data);
         memcpy(ptr, &data, sizeof(uint64_t));
+        invalidate_code(paddr.paddr, sizeof(uint64_t));
+    }
+
+    void CPU::invalidate_code(uint32_t paddr, uint32_t length)
+    {
+        rcp_.vi_.MarkWritten(paddr, length);
+        if (paddr <= RSP_IMEM_END && paddr + length > RSP_IMEM_START)
+        {
+            rcp_.rsp_.invalidate_imem();
+        }
+
+#ifdef HYDRA_N64_JIT
+        jit_->Invalidate(paddr, length);
+#endif
+
+        // Decoded pages are updated in place so pointers into them stay valid
+        uint64_t end = static_cast<uint64_t>(paddr) + length;
+        uint64_t address = paddr & ~0b11u;
+        while (address < end)
+        {
+            uint64_t page = address >> DECODED_PAGE_SHIFT;
+            if (page >= decoded_pages_.size())
+            {
+                break;
+            }
+            uint64_t page_end = std::min((page + 1) << DECODED_PAGE_SHIFT, end);
+            DecodedPage* decoded_page = decoded_pages_[page].get();
+            if (decoded_page)
+            {
+                for (; address < page_end; address += 4)
+                {
+                    (*decoded_page)[(address & DECODED_PAGE_MASK) >> 2] =
+                        decode_instruction(read_instruction(address));
+                }
+            }
+            address = (page + 1) << DECODED_PAGE_SHIFT;
+        }
+    }
+
+    CPU::DecodedInstruction CPU::decode_instruction(Instruction instruction)
+    {
+        DecodedInstruction decoded;
+        switch (instruction.IType.op)
+        {
+            case 0x00:
+                decoded.handler = special_table_[instruction.RType.func];
+                break;
+            case 0x01:
+                decoded.handler = regimm_table_[instruction.RType.rt];
+                break;
+            default:
+                decoded.handler = instruction_table_[instruction.IType.op];
+                break;
+        }
+        decoded.instruction = instruction;
+        decoded.rs = instruction.RType.rs;
+        decoded.rt = instruction.RType.rt;
+        decoded.rd = instruction.RType.rd;
+        decoded.sa = instruction.RType.sa;
+        decoded.seimm = static_cast<int16_t>(instruction.IType.immediate);
+        return decoded;
+    }
+
+    Instruction CPU::read_instruction(uint32_t paddr)
+    {
+        uint8_t* ptr = cpubus_.redirect_paddress(paddr);
+        uint32_t data;
+        std::memcpy(&data, ptr, sizeof(uint32_t));
+        Instruction instruction;
+        instruction.full = hydra::bswap32(data);
+        return instruction;
+    }
+
+    CPU::DecodedPage* CPU::get_decoded_page(uint32_t paddr)
+    {
+        uint32_t page = paddr >> DECODED_PAGE_SHIFT;
+        if (page >= decoded_pages_.size())
+        {
+            return nullptr;
+        }
+
+        if (!decoded_pages_[page]) [[unlikely]]
+        {
+            // SP memory is also written by the RSP, so only RDRAM and the cartridge are cached
+            bool cacheable = paddr < cpubus_.rdram_.size() || paddr >= 0x1000'0000;
+            uint32_t page_start = paddr & ~DECODED_PAGE_MASK;
+            if (!cacheable || !cpubus_.redirect_paddress(page_start))
+            {
+                return nullptr;
+            }
+
+            decoded_pages_[page] = std::make_unique<DecodedPage>();
+            DecodedPage& decoded_page = *decoded_pages_[page];
+            for (size_t i = 0; i < decoded_page.size(); i++)
+            {
+                decoded_page[i] = decode_instruction(read_instruction(page_start + i * 4));
+            }
+        }
+        return decoded_pages_[page].get();
+    }
+
+    const CPU::DecodedInstruction* CPU::fetch_instruction(uint32_t paddr)
+    {
+        DecodedPage* page = get_decoded_page(paddr);
+        if (page) [[likely]]
+        {
+            return &(*page)[(paddr & DECODED_PAGE_MASK) >> 2];
+        }
+        uncached_instruction_ = decode_instruction(read_instruction(paddr));
+        return &uncached_instruction_;
     }
 
     void CPU::Tick()
     {
         ++cpubus_.time_;
         cpubus_.time_ &= 0x1FFFFFFFF;
-        if (cpubus_.time_ == (cp0_regs_[CP0_COMPARE].UD << 1)) [[unlikely]]
-        {
-            CP0Cause.IP7 = true;
-            update_interrupt_check();
-        }
         gpr_regs_[0].UD = 0;
         prev_branch_ = was_branch_;
         was_branch_ = false;
         TranslatedAddress paddr = translate_vaddr(pc_);
-        uint8_t* ptr = cpubus_.redirect_paddress(paddr.paddr);
-        instruction_.full = hydra::bswap32(*reinterpret_cast<uint32_t*>(ptr));
+        decoded_ = fetch_instruction(paddr.paddr);
+        instruction_ = decoded_->instruction;
         if (check_interrupts())
         {
             return;
@@ -1105,7 +1483,7 @@ namespace hydra::N64
         prev_pc_ = pc_;
         pc_ = next_pc_;
         next_pc_ += 4;
-        execute_instruction();
+        decoded_->handler(this);
     }
 
     void CPU::check_vi_interrupt()
@@ -1117,6 +1495,37 @@ namespace hydra::N64
         }
     }
 
+    void CPU::schedule_compare_event()
+    {
+        // Count increments every other cycle, time_ is the 33-bit cycle counter behind it
+        uint64_t delay = ((cp0_regs_[CP0_COMPARE].UD << 1) - cpubus_.time_) & 0x1FFFFFFFF;
+        if (delay == 0)
+        {
+            delay = 0x200000000;
+        }
+        scheduler_.Schedule(SchedulerEventType::Compare, delay);
+    }
+
+    void CPU::compare_event()
+    {
+        CP0Cause.IP7 = true;
+        update_interrupt_check();
+        schedule_compare_event();
+    }
+
+    void CPU::pi_dma_event()
+    {
+        cpubus_.dma_busy_ = false;
+        set_interrupt(InterruptType::PI, true);
+        Logger::Debug("Raising PI interrupt");
+    }
+
+    void CPU::si_dma_event()
+    {
+        set_interrupt(InterruptType::SI, true);
+        Logger::Debug("Raising SI interrupt");
+    }
+
     bool CPU::check_interrupts()
     {
         if (should_service_interrupt_)
@@ -1161,11 +1570,6 @@ namespace hydra::N64
         was_branch_ = true;
     }
 
-    void CPU::execute_instruction()
-    {
-        (instruction_table_[instruction_.IType.op])(this);
-    }
-
     void CPU::execute_cp0_instruction()
     {
         uint32_t func = instruction_.RType.rs;
@@ -1197,25 +1601,7 @@ namespace hydra::N64
                 }
                 case CP0Instruction::TLBWI:
                 {
-                    uint8_t index = cp0_regs_[CP0_INDEX].UD & 0b11111;
-
-                    TLBEntry entry;
-                    EntryLo el0, el1;
-                    EntryHi eh;
-                    uint16_t mask = (cp0_regs_[CP0_PAGEMASK].UD >> 13) & 0b101010101010;
-                    mask |= mask >> 1;
-                    entry.mask = mask;
-                    el0.full = cp0_regs_[CP0_ENTRYLO0].UD;
-                    el1.full = cp0_regs_[CP0_ENTRYLO1].UD;
-                    eh.full = cp0_regs_[CP0_ENTRYHI].UD;
-                    entry.G = el0.G && el1.G;
-                    entry.entry_even.full = el0.full & 0x3FF'FFFE;
-                    entry.entry_odd.full = el1.full & 0x3FF'FFFE;
-                    eh.VPN2 &= ~entry.mask;
-                    entry.entry_hi.full = eh.full;
-                    entry.initialized = true;
-
-                    tlb_[index] = entry;
+                    write_tlb_entry(cp0_regs_[CP0_INDEX].UD & 0b11111);
                     break;
                 }
                 case CP0Instruction::TLBP:
@@ -1260,7 +1646,8 @@ namespace hydra::N64
                 }
                 case CP0Instruction::TLBWR:
                 {
-                    return Logger::Warn("TLBWR is not implemented");
+                    write_tlb_entry(get_cp0_register_32(CP0_RANDOM) & 0b11111);
+                    break;
                 }
                 case CP0Instruction::WAIT:
                 {
@@ -1334,6 +1721,37 @@ namespace hydra::N64
         }
     }
 
+    void CPU::write_tlb_entry(uint8_t index)
+    {
+        TLBEntry entry;
+        EntryLo el0, el1;
+        EntryHi eh;
+        uint16_t mask = (cp0_regs_[CP0_PAGEMASK].UD >> 13) & 0b101010101010;
+        mask |= mask >> 1;
+        entry.mask = mask;
+        el0.full = cp0_regs_[CP0_ENTRYLO0].UD;
+        el1.full = cp0_regs_[CP0_ENTRYLO1].UD;
+        eh.full = cp0_regs_[CP0_ENTRYHI].UD;
+        entry.G = el0.G && el1.G;
+        entry.entry_even.full = el0.full & 0x3FF'FFFE;
+        entry.entry_odd.full = el1.full & 0x3FF'FFFE;
+        eh.VPN2 &= ~entry.mask;
+        entry.entry_hi.full = eh.full;
+        entry.initialized = true;
+
+        tlb_[index] = entry;
+        invalidate_tlb_cache();
+    }
+
+    void CPU::invalidate_tlb_cache()
+    {
+        if (++tlb_generation_ == 0) [[unlikely]]
+        {
+            tlb_cache_.fill({});
+            tlb_generation_ = 1;
+        }
+    }
+
     TranslatedAddress CPU::probe_tlb(uint32_t vaddr)
     {
         for (const TLBEntry& entry : tlb_)
@@ -1376,7 +1794,7 @@ namespace hydra::N64
                 };
             }
         }
-        Logger::Warn("TLB miss at {:08x}", vaddr);
+        Logger::Debug("TLB miss at {:08x}", vaddr);
         return {};
     }
 
@@ -1392,6 +1810,7 @@ namespace hydra::N64
 
     void CPU::throw_exception(uint32_t address, ExceptionType type, uint8_t processor)
     {
+        N64_PROFILE_COUNT_AT(Exceptions, static_cast<uint32_t>(type), 1);
         if (!CP0Status.EXL)
         {
             int64_t new_pc = static_cast<int32_t>(address);
@@ -1445,12 +1864,12 @@ namespace hydra::N64
         }
     }
 
-#define rdreg (gpr_regs_[instruction_.RType.rd])
-#define rsreg (gpr_regs_[instruction_.RType.rs])
-#define rtreg (gpr_regs_[instruction_.RType.rt])
-#define saval (instruction_.RType.sa)
-#define immval (instruction_.IType.immediate)
-#define seimmval (static_cast<int64_t>(static_cast<int16_t>(instruction_.IType.immediate)))
+#define rdreg (gpr_regs_[decoded_->rd])
+#define rsreg (gpr_regs_[decoded_->rs])
+#define rtreg (gpr_regs_[decoded_->rt])
+#define saval (decoded_->sa)
+#define immval (static_cast<uint16_t>(decoded_->seimm))
+#define seimmval (decoded_->seimm)
 #define fmtval (instruction_.FType.fmt)
 #define ftreg (fpr_regs_[instruction_.FType.ft])
 #define fsreg (fpr_regs_[instruction_.FType.fs])
@@ -2741,11 +3160,13 @@ namespace hydra::N64
             {
                 CP0Cause.IP7 = false;
                 cp0_regs_[reg].UD = value;
+                schedule_compare_event();
                 break;
             }
             case CP0_COUNT:
             {
                 cpubus_.time_ = value << 1;
+                schedule_compare_event();
                 break;
             }
             case CP0_CONFIG:
@@ -3201,6 +3622,7 @@ namespace hydra::N64
             case 31:
             {
                 fcr31_.full = rtreg.UW._0 & 0x183ffff;
+                update_host_round_mode();
                 check_fpu_exception();
                 break;
             }
@@ -3390,31 +3812,15 @@ namespace hydra::N64
                 return;
             }
         }
-        int round_mode = std::fegetround();
-        switch (fcr31_.rounding_mode)
+        // Host exception flags are left to accumulate and only cleared when actually set, as
+        // reading them is much cheaper than writing them. Every flag is still tested after the
+        // operation, the FCR31 cause bits have to be exact
+        constexpr int watched = FE_INEXACT | FE_UNDERFLOW | FE_OVERFLOW | FE_DIVBYZERO | FE_INVALID;
+        int stale = std::fetestexcept(watched);
+        if (stale)
         {
-            case 0:
-            {
-                std::fesetround(FE_TONEAREST);
-                break;
-            }
-            case 1:
-            {
-                std::fesetround(FE_TOWARDZERO);
-                break;
-            }
-            case 2:
-            {
-                std::fesetround(FE_UPWARD);
-                break;
-            }
-            case 3:
-            {
-                std::fesetround(FE_DOWNWARD);
-                break;
-            }
+            std::feclearexcept(stale);
         }
-        std::feclearexcept(FE_ALL_EXCEPT);
         Type result{};
         // if takes 1 parameter
         if constexpr (std::is_invocable<decltype(op), Type>())
@@ -3425,7 +3831,7 @@ namespace hydra::N64
         {
             result = std::invoke(op, fs, ft);
         }
-        int exception = fetestexcept(FE_ALL_EXCEPT);
+        int exception = std::fetestexcept(watched);
         if (exception & FE_UNDERFLOW)
         {
             if (!fcr31_.flush_subnormals || fcr31_.enable_underflow || fcr31_.enable_inexact)
@@ -3471,7 +3877,6 @@ namespace hydra::N64
                 fcr31_.flag_invalidop = 1;
             }
         }
-        std::fesetround(round_mode);
         check_fpu_result(result);
         if (check_fpu_exception())
         {
@@ -3480,6 +3885,35 @@ namespace hydra::N64
         fdreg.UD = cast(result);
     }
 
+    void CPU::update_host_round_mode()
+    {
+        static constexpr std::array<int, 4> host_round_modes = {FE_TONEAREST, FE_TOWARDZERO,
+                                                                FE_UPWARD, FE_DOWNWARD};
+        int mode = host_round_modes[fcr31_.rounding_mode];
+        if (host_fp_env_active_ && mode != host_round_mode_)
+        {
+            std::fesetround(mode);
+            host_round_mode_ = mode;
+        }
+    }
+
+    void CPU::EnterHostFpEnvironment()
+    {
+        saved_host_round_mode_ = std::fegetround();
+        host_round_mode_ = saved_host_round_mode_;
+        host_fp_env_active_ = true;
+        update_host_round_mode();
+    }
+
+    void CPU::ExitHostFpEnvironment()
+    {
+        if (host_round_mode_ != saved_host_round_mode_)
+        {
+            std::fesetround(saved_host_round_mode_);
+        }
+        host_fp_env_active_ = false;
+    }
+
     template <class OperatorFunction, class CastFunction>
     void CPU::fpu_operate(OperatorFunction op, CastFunction cast)
     {
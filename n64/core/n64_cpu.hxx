@@ -12,9 +12,13 @@
 #include <log.hxx>
 #include <memory>
 #include <n64/core/n64_addresses.hxx>
+#include <n64/core/n64_fastmem.hxx>
 #include <n64/core/n64_rcp.hxx>
+#include <n64/core/n64_scheduler.hxx>
 #include <n64/core/n64_types.hxx>
 #include <queue>
+#include <span>
+#include <state.hxx>
 #include <vector>
 
 #define KB(x) (static_cast<size_t>(x << 10))
@@ -25,6 +29,7 @@ constexpr uint32_t KSEG0_START = 0x8000'0000;
 constexpr uint32_t KSEG0_END = 0x9FFF'FFFF;
 constexpr uint32_t KSEG1_START = 0xA000'0000;
 constexpr uint32_t KSEG1_END = 0xBFFF'FFFF;
+constexpr uint64_t SI_DMA_CYCLES = 0x1200;
 
 enum class ExceptionType
 {
@@ -165,6 +170,7 @@ namespace hydra
     {
         class N64;
         class QA;
+        class CPUJit;
     } // namespace N64
 } // namespace hydra
 
@@ -234,6 +240,8 @@ namespace hydra::N64
         uint32_t paddr;
         bool cached;
         bool success = false;
+        // Set when the address is known to be plain RDRAM, skipping the bus lookup
+        uint8_t* host = nullptr;
     };
 
     /**
@@ -254,16 +262,41 @@ namespace hydra::N64
         }
 
         void Reset();
+        void SaveState(StateWriter& writer) const;
+        void LoadState(StateReader& reader);
 
     private:
-        hydra_inline uint8_t* redirect_paddress(uint32_t paddr);
+        hydra_inline uint8_t* redirect_paddress(uint32_t paddr, bool write = false)
+        {
+            uint8_t* ptr = page_table_[paddr >> 16];
+            if (ptr) [[likely]]
+            {
+                if ((paddr >> 16) == (RSP_DMEM_START >> 16)) [[unlikely]]
+                {
+                    rcp_.rsp_.Sync();
+                }
+                rcp_.rdp_.FlushIfPending(paddr, write);
+                ptr += (paddr & static_cast<uint32_t>(0xFFFF));
+                return ptr;
+            }
+            else if (paddr - 0x1FC00000u < 1984u)
+            {
+                return &ipl_[paddr - 0x1FC00000u];
+            }
+            return nullptr;
+        }
+
         void map_direct_addresses();
+        void reset_cartridge_domain();
+        void normalize_cartridge_byte_order(size_t size);
 
         static std::vector<uint8_t> ipl_;
-        std::vector<uint8_t> cart_rom_;
+        // Guest memory that lives at its physical address inside the arena
+        FastmemArena fastmem_;
+        std::span<uint8_t> cart_rom_{};
         bool rom_loaded_ = false;
         bool ipl_loaded_ = false;
-        std::vector<uint8_t> rdram_{};
+        std::span<uint8_t> rdram_{};
         std::vector<uint8_t> sram_{};
         std::array<char, ISVIEWER_AREA_END - ISVIEWER_AREA_START> isviewer_buffer_{};
         std::array<uint8_t, 64> pif_ram_{};
@@ -312,6 +345,7 @@ namespace hydra::N64
         RCP& rcp_;
         friend class CPU;
         friend class hydra::N64::N64;
+        friend class hydra::N64::CPUJit;
     };
 
     template <auto MemberFunc>
@@ -336,15 +370,27 @@ namespace hydra::N64
     class CPU final
     {
     public:
-        CPU(CPUBus& cpubus, RCP& rcp);
+        CPU(CPUBus& cpubus, RCP& rcp, Scheduler& scheduler);
+        ~CPU();
         void Tick();
         void Reset();
+        void SaveState(StateWriter& writer) const;
+        void LoadState(StateReader& reader);
+
+        // While entered, the host rounding mode follows FCR31 instead of being switched for every
+        // FPU operation. Exiting restores whatever the thread used before
+        void EnterHostFpEnvironment();
+        void ExitHostFpEnvironment();
 
     private:
         using PipelineStageRet = void;
         using PipelineStageArgs = void;
         CPUBus& cpubus_;
         RCP& rcp_;
+        Scheduler& scheduler_;
+#ifdef HYDRA_N64_JIT
+        std::unique_ptr<CPUJit> jit_;
+#endif
 
         OperatingMode opmode_ = OperatingMode::Kernel;
         // To be used with OpcodeMasks (OpcodeMasks[mode64_])
@@ -366,6 +412,9 @@ namespace hydra::N64
         uint64_t fcr0_;
         Instruction instruction_;
         FCR31 fcr31_;
+        int host_round_mode_ = FE_TONEAREST;
+        int saved_host_round_mode_ = FE_TONEAREST;
+        bool host_fp_env_active_ = false;
         uint32_t cp0_weirdness_;
         uint64_t cp2_weirdness_;
         bool prev_branch_ = false, was_branch_ = false;
@@ -381,6 +430,29 @@ namespace hydra::N64
         hydra_inline TranslatedAddress translate_vaddr(uint32_t vaddr);
         hydra_inline TranslatedAddress translate_vaddr_kernel(uint32_t vaddr);
         hydra_inline TranslatedAddress probe_tlb(uint32_t vaddr);
+        hydra_inline uint8_t* redirect_translated(const TranslatedAddress& paddr,
+                                                  bool write = false);
+        hydra_inline void invalidate_code(uint32_t paddr, uint32_t length);
+        void write_tlb_entry(uint8_t index);
+        void invalidate_tlb_cache();
+        void invalidate_all_code();
+
+        // Direct-mapped cache of user segment translations, one entry per 4KB page tagged by the
+        // ASID it was looked up with. Writing the TLB bumps tlb_generation_, which makes every
+        // older entry miss without having to clear them
+        struct TLBCacheEntry
+        {
+            uint32_t vpage = 0;
+            uint32_t ppage = 0;
+            uint8_t* host = nullptr;
+            uint32_t generation = 0;
+            uint8_t asid = 0;
+            bool cached = false;
+        };
+
+        static constexpr size_t TLB_CACHE_SIZE = 0x1000;
+        std::array<TLBCacheEntry, TLB_CACHE_SIZE> tlb_cache_{};
+        uint32_t tlb_generation_ = 1;
 
         uint32_t read_hwio(uint32_t addr);
         void write_hwio(uint32_t addr, uint32_t data);
@@ -464,7 +536,30 @@ namespace hydra::N64
         };
         // clang-format on
 
-        void execute_instruction();
+        // An instruction with its fields already extracted and its handler already looked up
+        struct DecodedInstruction
+        {
+            func_ptr handler;
+            Instruction instruction;
+            uint8_t rs, rt, rd, sa;
+            int64_t seimm;
+        };
+
+        static constexpr uint32_t DECODED_PAGE_SHIFT = 12;
+        static constexpr uint32_t DECODED_PAGE_MASK = (1u << DECODED_PAGE_SHIFT) - 1;
+        using DecodedPage = std::array<DecodedInstruction, (1u << DECODED_PAGE_SHIFT) / 4>;
+
+        // Indexed by physical page, only RDRAM and cartridge pages are ever decoded
+        std::vector<std::unique_ptr<DecodedPage>> decoded_pages_;
+        // Holds instructions fetched from memory that isn't cached, like the SP memory
+        DecodedInstruction uncached_instruction_;
+        const DecodedInstruction* decoded_ = &uncached_instruction_;
+
+        static DecodedInstruction decode_instruction(Instruction instruction);
+        hydra_inline Instruction read_instruction(uint32_t paddr);
+        hydra_inline const DecodedInstruction* fetch_instruction(uint32_t paddr);
+        DecodedPage* get_decoded_page(uint32_t paddr);
+
         void execute_cp0_instruction();
 
         void conditional_branch(bool condition, uint64_t address);
@@ -487,6 +582,10 @@ namespace hydra::N64
         void handle_event();
         uint32_t timing_pi_access(uint8_t domain, uint32_t length);
         void check_vi_interrupt();
+        void schedule_compare_event();
+        void compare_event();
+        void pi_dma_event();
+        void si_dma_event();
         void throw_exception(uint32_t, ExceptionType, uint8_t = 0);
         uint32_t get_cp0_register_32(uint8_t reg);
         uint64_t get_cp0_register_64(uint8_t reg);
@@ -525,6 +624,7 @@ namespace hydra::N64
         void set_fpu_reg(int regnum, Type value);
 
         bool check_fpu_exception();
+        void update_host_round_mode();
 
         void pif_command();
         bool joybus_command(const std::vector<uint8_t>&, std::vector<uint8_t>&);
@@ -546,5 +646,6 @@ namespace hydra::N64
         std::function<int8_t(int, int, int)> read_input_callback_;
 
         friend class hydra::N64::N64;
+        friend class hydra::N64::CPUJit;
     };
 } // namespace hydra::N64
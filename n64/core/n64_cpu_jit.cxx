@@ -0,0 +1,814 @@
+#include <algorithm>
+#include <compatibility.hxx>
+#include <cstring>
+#include <log.hxx>
+#include <n64/core/n64_cpu.hxx>
+#include <n64/core/n64_cpu_jit.hxx>
+#include <mutex>
+#include <signal.h>
+#include <sys/mman.h>
+
+#if !defined(__x86_64__) || defined(_WIN32)
+#error "The N64 JIT only supports x86-64 System V hosts"
+#endif
+
+namespace
+{
+    // Just enough of an x86-64 assembler for what the block compiler emits. Memory operands are
+    // [rbx + disp32], rbx holding the CPU pointer for the lifetime of the block, except for
+    // fastmem loads which go through rcx.
+    class Emitter
+    {
+    public:
+        Emitter(uint8_t* ptr) : start_(ptr), ptr_(ptr) {}
+
+        size_t Size() const
+        {
+            return ptr_ - start_;
+        }
+
+        void PushRbx()
+        {
+            emit8(0x53);
+        }
+
+        void MovRbxRdi()
+        {
+            emit8(0x48);
+            emit8(0x89);
+            emit8(0xFB);
+        }
+
+        void MovRdiRbx()
+        {
+            emit8(0x48);
+            emit8(0x89);
+            emit8(0xDF);
+        }
+
+        void MovRaxImm64(uint64_t imm)
+        {
+            emit8(0x48);
+            emit8(0xB8);
+            emit64(imm);
+        }
+
+        void CallRax()
+        {
+            emit8(0xFF);
+            emit8(0xD0);
+        }
+
+        // mov qword [rbx + disp], simm32
+        void MovM64Imm32(int32_t disp, int32_t imm)
+        {
+            emit8(0x48);
+            emit8(0xC7);
+            emit8(0x83);
+            emit32(disp);
+            emit32(imm);
+        }
+
+        // mov dword [rbx + disp], imm32
+        void MovM32Imm32(int32_t disp, uint32_t imm)
+        {
+            emit8(0xC7);
+            emit8(0x83);
+            emit32(disp);
+            emit32(imm);
+        }
+
+        // mov rax, qword [rbx + disp]
+        void MovRaxM64(int32_t disp)
+        {
+            emit8(0x48);
+            emit8(0x8B);
+            emit8(0x83);
+            emit32(disp);
+        }
+
+        // mov qword [rbx + disp], rax
+        void MovM64Rax(int32_t disp)
+        {
+            emit8(0x48);
+            emit8(0x89);
+            emit8(0x83);
+            emit32(disp);
+        }
+
+        void AddRaxImm8(int8_t imm)
+        {
+            emit8(0x48);
+            emit8(0x83);
+            emit8(0xC0);
+            emit8(imm);
+        }
+
+        // mov byte [rbx + disp], imm8
+        void MovM8Imm8(int32_t disp, uint8_t imm)
+        {
+            emit8(0xC6);
+            emit8(0x83);
+            emit32(disp);
+            emit8(imm);
+        }
+
+        // mov al, byte [rbx + disp]
+        void MovAlM8(int32_t disp)
+        {
+            emit8(0x8A);
+            emit8(0x83);
+            emit32(disp);
+        }
+
+        // mov byte [rbx + disp], al
+        void MovM8Al(int32_t disp)
+        {
+            emit8(0x88);
+            emit8(0x83);
+            emit32(disp);
+        }
+
+        // cmp qword [rbx + disp], simm32
+        void CmpM64Imm32(int32_t disp, int32_t imm)
+        {
+            emit8(0x48);
+            emit8(0x81);
+            emit8(0xBB);
+            emit32(disp);
+            emit32(imm);
+        }
+
+        // cmp byte [rax], imm8
+        void CmpRaxM8Imm8(uint8_t imm)
+        {
+            emit8(0x80);
+            emit8(0x38);
+            emit8(imm);
+        }
+
+        void AddRaxImm32(int32_t imm)
+        {
+            emit8(0x48);
+            emit8(0x05);
+            emit32(imm);
+        }
+
+        void AndEaxImm32(uint32_t imm)
+        {
+            emit8(0x25);
+            emit32(imm);
+        }
+
+        void TestAlImm8(uint8_t imm)
+        {
+            emit8(0xA8);
+            emit8(imm);
+        }
+
+        void MovEcxImm32(uint32_t imm)
+        {
+            emit8(0xB9);
+            emit32(imm);
+        }
+
+        void MovRcxImm64(uint64_t imm)
+        {
+            emit8(0x48);
+            emit8(0xB9);
+            emit64(imm);
+        }
+
+        void AddRcxRax()
+        {
+            emit8(0x48);
+            emit8(0x01);
+            emit8(0xC1);
+        }
+
+        void CmpRcxImm32(int32_t imm)
+        {
+            emit8(0x48);
+            emit8(0x81);
+            emit8(0xF9);
+            emit32(imm);
+        }
+
+        // cmp dword [rcx], imm8
+        void CmpRcxM32Imm8(int8_t imm)
+        {
+            emit8(0x83);
+            emit8(0x39);
+            emit8(imm);
+        }
+
+        // Loads size bytes from [rcx + rax] into rax, byteswapped and extended to 64 bits
+        void LoadRcxRax(int size, bool sign_extend)
+        {
+            switch (size)
+            {
+                case 1:
+                {
+                    if (sign_extend)
+                    {
+                        emit8(0x48);
+                    }
+                    emit8(0x0F);
+                    emit8(sign_extend ? 0xBE : 0xB6);
+                    emit8(0x04);
+                    emit8(0x01);
+                    break;
+                }
+                case 2:
+                {
+                    // movzx eax, word [rcx + rax]; rol ax, 8
+                    emit8(0x0F);
+                    emit8(0xB7);
+                    emit8(0x04);
+                    emit8(0x01);
+                    emit8(0x66);
+                    emit8(0xC1);
+                    emit8(0xC0);
+                    emit8(0x08);
+                    if (sign_extend)
+                    {
+                        emit8(0x48);
+                    }
+                    emit8(0x0F);
+                    emit8(sign_extend ? 0xBF : 0xB7);
+                    emit8(0xC0);
+                    break;
+                }
+                case 4:
+                {
+                    // mov eax, dword [rcx + rax]; bswap eax
+                    emit8(0x8B);
+                    emit8(0x04);
+                    emit8(0x01);
+                    emit8(0x0F);
+                    emit8(0xC8);
+                    if (sign_extend)
+                    {
+                        // movsxd rax, eax
+                        emit8(0x48);
+                        emit8(0x63);
+                        emit8(0xC0);
+                    }
+                    break;
+                }
+                case 8:
+                {
+                    emit8(0x48);
+                    emit8(0x8B);
+                    emit8(0x04);
+                    emit8(0x01);
+                    emit8(0x48);
+                    emit8(0x0F);
+                    emit8(0xC8);
+                    break;
+                }
+            }
+        }
+
+        // Jumps return where their rel32 lives so they can be bound once the target is known
+        uint8_t* JumpIfAboveOrEqual()
+        {
+            emit8(0x0F);
+            emit8(0x83);
+            return emit_rel32();
+        }
+
+        uint8_t* JumpIfNotEqual()
+        {
+            emit8(0x0F);
+            emit8(0x85);
+            return emit_rel32();
+        }
+
+        uint8_t* Jump()
+        {
+            emit8(0xE9);
+            return emit_rel32();
+        }
+
+        void Bind(uint8_t* rel32)
+        {
+            int32_t displacement = static_cast<int32_t>(ptr_ - (rel32 + 4));
+            std::memcpy(rel32, &displacement, sizeof(displacement));
+        }
+
+        uint8_t* Here() const
+        {
+            return ptr_;
+        }
+
+        // Returns the amount of executed instructions
+        void Exit(int instructions)
+        {
+            emit8(0xB8);
+            emit32(instructions);
+            emit8(0x5B);
+            emit8(0xC3);
+        }
+
+        // Exits if the flags of the previous compare say not equal
+        void ExitIfNotEqual(int instructions)
+        {
+            // je over the 7 byte exit sequence
+            emit8(0x74);
+            emit8(0x07);
+            Exit(instructions);
+        }
+
+    private:
+        uint8_t* start_;
+        uint8_t* ptr_;
+
+        void emit8(uint8_t data)
+        {
+            *ptr_++ = data;
+        }
+
+        void emit32(uint32_t data)
+        {
+            std::memcpy(ptr_, &data, sizeof(data));
+            ptr_ += sizeof(data);
+        }
+
+        void emit64(uint64_t data)
+        {
+            std::memcpy(ptr_, &data, sizeof(data));
+            ptr_ += sizeof(data);
+        }
+
+        uint8_t* emit_rel32()
+        {
+            uint8_t* rel32 = ptr_;
+            emit32(0);
+            return rel32;
+        }
+    };
+
+    struct FastmemLoad
+    {
+        int size = 0;
+        bool sign_extend = false;
+    };
+
+    FastmemLoad get_fastmem_load(hydra::N64::Instruction instruction)
+    {
+        switch (instruction.IType.op)
+        {
+            case 0x20:
+                return {1, true};
+            case 0x21:
+                return {2, true};
+            case 0x23:
+                return {4, true};
+            case 0x24:
+                return {1, false};
+            case 0x25:
+                return {2, false};
+            case 0x27:
+                return {4, false};
+            case 0x37:
+                return {8, false};
+            default:
+                return {};
+        }
+    }
+
+    // The JIT running on this thread, if any, so the fault handler knows whose code faulted
+    thread_local hydra::N64::CPUJit* running_jit = nullptr;
+    struct sigaction previous_segv_action;
+    struct sigaction previous_bus_action;
+
+    void fault_handler(int signal, siginfo_t* info, void* context)
+    {
+        ucontext_t* ucontext = static_cast<ucontext_t*>(context);
+#if defined(__APPLE__)
+        uintptr_t rip = ucontext->uc_mcontext->__ss.__rip;
+#else
+        uintptr_t rip = ucontext->uc_mcontext.gregs[REG_RIP];
+#endif
+        if (running_jit && running_jit->HandleFault(rip))
+        {
+#if defined(__APPLE__)
+            ucontext->uc_mcontext->__ss.__rip = rip;
+#else
+            ucontext->uc_mcontext.gregs[REG_RIP] = rip;
+#endif
+            return;
+        }
+
+        const struct sigaction& previous =
+            signal == SIGSEGV ? previous_segv_action : previous_bus_action;
+        if (previous.sa_flags & SA_SIGINFO)
+        {
+            previous.sa_sigaction(signal, info, context);
+        }
+        else if (previous.sa_handler != SIG_DFL && previous.sa_handler != SIG_IGN)
+        {
+            previous.sa_handler(signal);
+        }
+        else
+        {
+            // Returning retries the access, which now takes the default action
+            ::signal(signal, SIG_DFL);
+        }
+    }
+
+    void install_fault_handler()
+    {
+        static std::once_flag once;
+        std::call_once(once, [] {
+            struct sigaction action = {};
+            action.sa_sigaction = fault_handler;
+            action.sa_flags = SA_SIGINFO;
+            sigemptyset(&action.sa_mask);
+            sigaction(SIGSEGV, &action, &previous_segv_action);
+            sigaction(SIGBUS, &action, &previous_bus_action);
+        });
+    }
+
+    bool is_branch(hydra::N64::Instruction instruction)
+    {
+        switch (instruction.IType.op)
+        {
+            // REGIMM also holds the trap instructions, treating them as branches is harmless
+            case 0x01:
+            case 0x02:
+            case 0x03:
+            case 0x04:
+            case 0x05:
+            case 0x06:
+            case 0x07:
+            case 0x14:
+            case 0x15:
+            case 0x16:
+            case 0x17:
+                return true;
+            case 0x00:
+                return instruction.RType.func == 0x08 || instruction.RType.func == 0x09;
+            case 0x11:
+                return instruction.RType.rs == 0x08;
+            default:
+                return false;
+        }
+    }
+
+    bool is_cop0(hydra::N64::Instruction instruction)
+    {
+        return instruction.IType.op == 0x10;
+    }
+
+    bool is_store(hydra::N64::Instruction instruction)
+    {
+        switch (instruction.IType.op)
+        {
+            case 0x28:
+            case 0x29:
+            case 0x2A:
+            case 0x2B:
+            case 0x2C:
+            case 0x2D:
+            case 0x2E:
+            case 0x38:
+            case 0x39:
+            case 0x3C:
+            case 0x3D:
+            case 0x3F:
+                return true;
+            default:
+                return false;
+        }
+    }
+} // namespace
+
+namespace hydra::N64
+{
+    CPUJit::CPUJit(CPU& cpu) : cpu_(cpu)
+    {
+        void* buffer = mmap(nullptr, CODE_BUFFER_SIZE, PROT_READ | PROT_WRITE | PROT_EXEC,
+                            MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (buffer == MAP_FAILED)
+        {
+            Logger::Warn("JIT: Could not allocate executable memory, falling back to interpreter");
+            return;
+        }
+        code_buffer_ = static_cast<uint8_t*>(buffer);
+        SetFastmem(true);
+    }
+
+    CPUJit::~CPUJit()
+    {
+        if (code_buffer_)
+        {
+            munmap(code_buffer_, CODE_BUFFER_SIZE);
+        }
+    }
+
+    int CPUJit::Run()
+    {
+        CPU& cpu = cpu_;
+        uint32_t pc = cpu.pc_;
+        // Blocks assume sequential execution on entry, so delay slots of taken branches and
+        // interrupts are handled by the interpreter
+        if (!code_buffer_ || cpu.should_service_interrupt_ ||
+            static_cast<uint32_t>(cpu.next_pc_) != pc + 4 || pc < KSEG0_START || pc > KSEG1_END ||
+            !cpu.is_kernel_mode())
+        {
+            cpu.Tick();
+            return 1;
+        }
+
+        uint32_t paddr = pc & 0x1FFF'FFFF;
+        Block* block = nullptr;
+        auto it = blocks_.find(paddr);
+        if (it != blocks_.end() && it->second.vaddr == pc) [[likely]]
+        {
+            block = &it->second;
+        }
+        else
+        {
+            block = compile(pc, paddr);
+        }
+
+        if (!block)
+        {
+            cpu.Tick();
+            return 1;
+        }
+
+        running_jit = this;
+        int cycles = block->code(&cpu);
+        running_jit = nullptr;
+        invalidated_ = false;
+        cpu.cpubus_.time_ = (cpu.cpubus_.time_ + cycles) & 0x1FFFFFFFF;
+        return cycles;
+    }
+
+    void CPUJit::Invalidate(uint32_t paddr, uint32_t length)
+    {
+        if (paddr >= RDRAM_PAGES << PAGE_SHIFT || length == 0)
+        {
+            return;
+        }
+
+        uint32_t end = std::min(paddr + length, RDRAM_PAGES << PAGE_SHIFT);
+        for (uint32_t page = paddr >> PAGE_SHIFT; page <= ((end - 1) >> PAGE_SHIFT); page++)
+        {
+            auto& page_blocks = page_blocks_[page];
+            if (page_blocks.empty()) [[likely]]
+            {
+                continue;
+            }
+
+            std::erase_if(page_blocks, [this, paddr, end](uint32_t key) {
+                auto it = blocks_.find(key);
+                if (it == blocks_.end())
+                {
+                    return true;
+                }
+                const Block& block = it->second;
+                if (block.paddr < end && paddr < block.paddr + block.size)
+                {
+                    blocks_.erase(it);
+                    invalidated_ = true;
+                    return true;
+                }
+                return false;
+            });
+        }
+    }
+
+    void CPUJit::SetFastmem(bool enabled)
+    {
+        bool fastmem = enabled && code_buffer_ && cpu_.cpubus_.fastmem_.Base();
+        if (fastmem)
+        {
+            install_fault_handler();
+        }
+        if (fastmem != fastmem_)
+        {
+            fastmem_ = fastmem;
+            Flush();
+        }
+    }
+
+    bool CPUJit::HandleFault(uintptr_t& rip)
+    {
+        auto it = fastmem_sites_.find(rip);
+        if (it == fastmem_sites_.end())
+        {
+            return false;
+        }
+
+        // A load that faulted once is most likely an MMIO access and would keep faulting, so
+        // it's patched to always take the slow path
+        const FastmemSite& site = it->second;
+        int32_t displacement = static_cast<int32_t>(site.slow_path - (site.patch + 5));
+        site.patch[0] = 0xE9;
+        std::memcpy(site.patch + 1, &displacement, sizeof(displacement));
+        rip = reinterpret_cast<uintptr_t>(site.slow_path);
+        return true;
+    }
+
+    void CPUJit::Flush()
+    {
+        blocks_.clear();
+        fastmem_sites_.clear();
+        for (auto& page_blocks : page_blocks_)
+        {
+            page_blocks.clear();
+        }
+        code_offset_ = 0;
+    }
+
+    CPUJit::Block* CPUJit::compile(uint32_t vaddr, uint32_t paddr)
+    {
+        // Blocks are compiled out of the interpreter's decoded pages, which only exist for memory
+        // that is tracked for writes
+        CPU::DecodedPage* page = cpu_.get_decoded_page(paddr);
+        if (!page)
+        {
+            return nullptr;
+        }
+
+        auto fetch = [page](uint32_t address) -> const CPU::DecodedInstruction& {
+            return (*page)[(address & CPU::DECODED_PAGE_MASK) >> 2];
+        };
+
+        if (is_cop0(fetch(paddr).instruction))
+        {
+            return nullptr;
+        }
+
+        if (code_offset_ + MAX_BLOCK_CODE_SIZE > CODE_BUFFER_SIZE)
+        {
+            Flush();
+        }
+
+        auto offset = [this](const void* member) {
+            return static_cast<int32_t>(reinterpret_cast<const uint8_t*>(member) -
+                                        reinterpret_cast<const uint8_t*>(&cpu_));
+        };
+        const int32_t gpr0_offset = offset(&cpu_.gpr_regs_[0]);
+        const int32_t instruction_offset = offset(&cpu_.instruction_);
+        const int32_t decoded_offset = offset(&cpu_.decoded_);
+        const int32_t prev_pc_offset = offset(&cpu_.prev_pc_);
+        const int32_t pc_offset = offset(&cpu_.pc_);
+        const int32_t next_pc_offset = offset(&cpu_.next_pc_);
+        const int32_t prev_branch_offset = offset(&cpu_.prev_branch_);
+        const int32_t was_branch_offset = offset(&cpu_.was_branch_);
+
+        uint8_t* code = code_buffer_ + code_offset_;
+        Emitter emitter(code);
+        emitter.PushRbx();
+        emitter.MovRbxRdi();
+
+        // Mirrors what CPU::Tick does for every instruction. Delay slots can't assume the
+        // branch wasn't taken so they advance from whatever next_pc_ the branch left behind.
+        auto emit_instruction = [&](const CPU::DecodedInstruction& decoded, uint32_t address,
+                                    bool delay_slot) {
+            emitter.MovM64Imm32(gpr0_offset, 0);
+            emitter.MovAlM8(was_branch_offset);
+            emitter.MovM8Al(prev_branch_offset);
+            emitter.MovM8Imm8(was_branch_offset, 0);
+            if (delay_slot)
+            {
+                emitter.MovRaxM64(next_pc_offset);
+                emitter.MovM64Rax(pc_offset);
+                emitter.AddRaxImm8(4);
+                emitter.MovM64Rax(next_pc_offset);
+            }
+            else
+            {
+                emitter.MovM64Imm32(pc_offset, static_cast<int32_t>(address + 4));
+                emitter.MovM64Imm32(next_pc_offset, static_cast<int32_t>(address + 8));
+            }
+
+            // Loads from kseg0/kseg1 read straight out of the fastmem arena. Misaligned
+            // addresses, pending or skipped RDP writes and unmapped memory take the handler instead
+            uint8_t* done = nullptr;
+            FastmemLoad load = fastmem_ ? get_fastmem_load(decoded.instruction) : FastmemLoad{};
+            if (load.size)
+            {
+                Instruction instruction = decoded.instruction;
+                emitter.MovRaxM64(offset(&cpu_.gpr_regs_[instruction.IType.rs]));
+                emitter.AddRaxImm32(static_cast<int16_t>(instruction.IType.immediate));
+                emitter.MovEcxImm32(KSEG0_START);
+                emitter.AddRcxRax();
+                emitter.CmpRcxImm32(KSEG1_END - KSEG0_START + 1);
+                uint8_t* unmapped = emitter.JumpIfAboveOrEqual();
+                uint8_t* misaligned = nullptr;
+                if (load.size > 1)
+                {
+                    emitter.TestAlImm8(load.size - 1);
+                    misaligned = emitter.JumpIfNotEqual();
+                }
+                emitter.AndEaxImm32(0x1FFF'FFFF);
+                emitter.MovRcxImm64(reinterpret_cast<uint64_t>(&cpu_.rcp_.rdp_.pending_size_));
+                emitter.CmpRcxM32Imm8(0);
+                uint8_t* rdp_pending = emitter.JumpIfNotEqual();
+                emitter.MovRcxImm64(reinterpret_cast<uint64_t>(&cpu_.rcp_.rdp_.skipped_any_));
+                emitter.CmpRcxM32Imm8(0);
+                uint8_t* rdp_skipped = emitter.JumpIfNotEqual();
+                uint8_t* patch = emitter.Here();
+                emitter.MovRcxImm64(reinterpret_cast<uint64_t>(cpu_.cpubus_.fastmem_.Base()));
+                uint8_t* access = emitter.Here();
+                emitter.LoadRcxRax(load.size, load.sign_extend);
+                if (instruction.IType.rt != 0)
+                {
+                    emitter.MovM64Rax(offset(&cpu_.gpr_regs_[instruction.IType.rt]));
+                }
+                done = emitter.Jump();
+
+                emitter.Bind(unmapped);
+                if (misaligned)
+                {
+                    emitter.Bind(misaligned);
+                }
+                emitter.Bind(rdp_pending);
+                emitter.Bind(rdp_skipped);
+                fastmem_sites_[reinterpret_cast<uintptr_t>(access)] = {patch, emitter.Here()};
+            }
+
+            emitter.MovM32Imm32(instruction_offset, decoded.instruction.full);
+            emitter.MovRaxImm64(reinterpret_cast<uint64_t>(&decoded));
+            emitter.MovM64Rax(decoded_offset);
+            emitter.MovM64Imm32(prev_pc_offset, static_cast<int32_t>(address));
+            emitter.MovRdiRbx();
+            emitter.MovRaxImm64(reinterpret_cast<uint64_t>(decoded.handler));
+            emitter.CallRax();
+
+            if (done)
+            {
+                emitter.Bind(done);
+            }
+        };
+
+        const uint32_t page_end = (paddr | ((1u << PAGE_SHIFT) - 1)) + 1;
+        uint32_t current_paddr = paddr;
+        uint32_t current_vaddr = vaddr;
+        int instructions = 0;
+
+        while (instructions < MAX_BLOCK_INSTRUCTIONS && current_paddr < page_end)
+        {
+            const CPU::DecodedInstruction& decoded = fetch(current_paddr);
+            Instruction instruction = decoded.instruction;
+            if (is_cop0(instruction))
+            {
+                break;
+            }
+
+            emit_instruction(decoded, current_vaddr, false);
+            instructions++;
+            current_paddr += 4;
+            current_vaddr += 4;
+
+            if (is_branch(instruction))
+            {
+                // A likely branch that isn't taken skips the delay slot
+                emitter.CmpM64Imm32(pc_offset, static_cast<int32_t>(current_vaddr));
+                emitter.ExitIfNotEqual(instructions);
+
+                if (current_paddr < page_end)
+                {
+                    const CPU::DecodedInstruction& delay_slot = fetch(current_paddr);
+                    if (!is_cop0(delay_slot.instruction) && !is_branch(delay_slot.instruction))
+                    {
+                        emit_instruction(delay_slot, current_vaddr, true);
+                        instructions++;
+                        current_paddr += 4;
+                    }
+                }
+                break;
+            }
+
+            // Exceptions move next_pc_ to the exception vector
+            emitter.CmpM64Imm32(next_pc_offset, static_cast<int32_t>(current_vaddr + 4));
+            emitter.ExitIfNotEqual(instructions);
+
+            if (is_store(instruction))
+            {
+                emitter.MovRaxImm64(reinterpret_cast<uint64_t>(&invalidated_));
+                emitter.CmpRaxM8Imm8(0);
+                emitter.ExitIfNotEqual(instructions);
+            }
+        }
+
+        emitter.Exit(instructions);
+        code_offset_ += emitter.Size();
+        // Keep blocks 16 byte aligned
+        code_offset_ = (code_offset_ + 15) & ~size_t(15);
+
+        auto [it, inserted] = blocks_.insert_or_assign(
+            paddr, Block{vaddr, paddr, current_paddr - paddr, reinterpret_cast<block_func_ptr>(code)});
+        if (inserted && paddr < (RDRAM_PAGES << PAGE_SHIFT))
+        {
+            page_blocks_[paddr >> PAGE_SHIFT].push_back(paddr);
+        }
+        return &it->second;
+    }
+} // namespace hydra::N64
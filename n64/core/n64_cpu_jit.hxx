@@ -0,0 +1,75 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace hydra::N64
+{
+    class CPU;
+
+    // Compiles straight-line runs of MIPS III code into x86-64 code that calls the interpreter
+    // handlers with all decoding, fetching and pc bookkeeping resolved at compile time.
+    // Anything that can remap memory or change the privilege level (COP0, TLB mapped code) and
+    // pending interrupts are left to the interpreter.
+    class CPUJit final
+    {
+    public:
+        CPUJit(CPU& cpu);
+        ~CPUJit();
+
+        // Runs the block at the current pc, or interprets a single instruction if there isn't one.
+        // Returns the amount of cycles executed.
+        int Run();
+        void Invalidate(uint32_t paddr, uint32_t length);
+        void Flush();
+
+        // Inlines kseg0/kseg1 loads as direct accesses into the fastmem arena. On by default when
+        // the arena could be reserved
+        void SetFastmem(bool enabled);
+
+        // Called from the SIGSEGV handler with the faulting instruction. If it's a fastmem load
+        // the site is patched to use the handler and rip is moved to it
+        bool HandleFault(uintptr_t& rip);
+
+    private:
+        using block_func_ptr = int (*)(CPU*);
+
+        struct Block
+        {
+            uint32_t vaddr;
+            uint32_t paddr;
+            uint32_t size;
+            block_func_ptr code;
+        };
+
+        struct FastmemSite
+        {
+            // The instruction that loads the arena base, overwritten with a jump to the slow path
+            uint8_t* patch;
+            uint8_t* slow_path;
+        };
+
+        static constexpr uint32_t PAGE_SHIFT = 12;
+        static constexpr uint32_t RDRAM_PAGES = 0x800000 >> PAGE_SHIFT;
+        static constexpr int MAX_BLOCK_INSTRUCTIONS = 64;
+        static constexpr size_t CODE_BUFFER_SIZE = 32 * 1024 * 1024;
+        // Worst case size of a single compiled block
+        static constexpr size_t MAX_BLOCK_CODE_SIZE = (MAX_BLOCK_INSTRUCTIONS + 1) * 256;
+
+        CPU& cpu_;
+        uint8_t* code_buffer_ = nullptr;
+        size_t code_offset_ = 0;
+        std::unordered_map<uint32_t, Block> blocks_;
+        std::array<std::vector<uint32_t>, RDRAM_PAGES> page_blocks_;
+        // Set when a store from inside a block invalidated compiled code, checked after every
+        // store so the block stops executing stale instructions
+        bool invalidated_ = false;
+        bool fastmem_ = false;
+        // Keyed by the address of the host instruction that accesses the arena
+        std::unordered_map<uintptr_t, FastmemSite> fastmem_sites_;
+
+        Block* compile(uint32_t vaddr, uint32_t paddr);
+    };
+} // namespace hydra::N64
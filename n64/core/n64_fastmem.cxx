@@ -0,0 +1,134 @@
+#include <cstring>
+#include <log.hxx>
+#include <n64/core/n64_fastmem.hxx>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace hydra::N64
+{
+    FastmemArena::FastmemArena()
+    {
+#if defined(_WIN32)
+        void* base = VirtualAlloc(nullptr, FASTMEM_ARENA_SIZE, MEM_RESERVE, PAGE_NOACCESS);
+        if (!base)
+        {
+            Logger::Warn("Could not reserve the fastmem arena");
+            return;
+        }
+#else
+        void* base = mmap(nullptr, FASTMEM_ARENA_SIZE, PROT_NONE,
+                          MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        if (base == MAP_FAILED)
+        {
+            Logger::Warn("Could not reserve the fastmem arena");
+            return;
+        }
+#endif
+        base_ = static_cast<uint8_t*>(base);
+    }
+
+    FastmemArena::~FastmemArena()
+    {
+        if (base_)
+        {
+#if defined(_WIN32)
+            VirtualFree(base_, 0, MEM_RELEASE);
+#else
+            munmap(base_, FASTMEM_ARENA_SIZE);
+#endif
+        }
+    }
+
+    uint8_t* FastmemArena::Commit(uint32_t paddr, size_t size)
+    {
+        if (paddr + size > FASTMEM_ARENA_SIZE)
+        {
+            Logger::Fatal("Fastmem commit out of range: {:08x}+{:x}", paddr, size);
+        }
+
+        if (base_)
+        {
+#if defined(_WIN32)
+            VirtualFree(base_ + paddr, size, MEM_DECOMMIT);
+            if (VirtualAlloc(base_ + paddr, size, MEM_COMMIT, PAGE_READWRITE))
+            {
+                return base_ + paddr;
+            }
+#else
+            // Mapping over the range replaces whatever was there, including file mappings
+            void* ptr = mmap(base_ + paddr, size, PROT_READ | PROT_WRITE,
+                             MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_FIXED, -1, 0);
+            if (ptr != MAP_FAILED)
+            {
+                return base_ + paddr;
+            }
+#endif
+            Logger::Fatal("Could not commit fastmem range {:08x}+{:x}", paddr, size);
+        }
+
+        for (FallbackRange& range : fallback_)
+        {
+            if (range.paddr == paddr && range.size == size)
+            {
+                std::memset(range.data.get(), 0, size);
+                return range.data.get();
+            }
+        }
+
+        uint8_t* data = static_cast<uint8_t*>(std::calloc(size, 1));
+        if (!data)
+        {
+            Logger::Fatal("Could not allocate {:x} bytes for {:08x}", size, paddr);
+        }
+        fallback_.push_back({paddr, size, std::unique_ptr<uint8_t[], FreeDeleter>(data)});
+        return data;
+    }
+
+    void FastmemArena::Decommit(uint32_t paddr, size_t size)
+    {
+        if (!base_)
+        {
+            return;
+        }
+
+#if defined(_WIN32)
+        VirtualFree(base_ + paddr, size, MEM_DECOMMIT);
+#else
+        mmap(base_ + paddr, size, PROT_NONE,
+             MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_FIXED, -1, 0);
+#endif
+    }
+
+    bool FastmemArena::MapFile([[maybe_unused]] uint32_t paddr,
+                               [[maybe_unused]] const std::string& path,
+                               [[maybe_unused]] size_t size)
+    {
+#if defined(_WIN32)
+        // Mapping a view into reserved memory needs placeholder support, just read it instead
+        return false;
+#else
+        if (!base_ || size == 0 || paddr + size > FASTMEM_ARENA_SIZE)
+        {
+            return false;
+        }
+
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+        {
+            return false;
+        }
+
+        // Writes stay private to the mapping like they did for the old in memory copy
+        void* ptr = mmap(base_ + paddr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, fd,
+                         0);
+        close(fd);
+        return ptr != MAP_FAILED;
+#endif
+    }
+} // namespace hydra::N64
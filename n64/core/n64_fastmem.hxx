@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace hydra::N64
+{
+    constexpr size_t FASTMEM_ARENA_SIZE = 0x2000'0000;
+
+    // Reserves the whole 512MB physical address space so guest memory can live at base + paddr.
+    // Only committed ranges are accessible, anything else (MMIO, open bus) faults when touched.
+    // If the reservation fails committed ranges are allocated separately and Base() is null.
+    class FastmemArena final
+    {
+    public:
+        FastmemArena();
+        ~FastmemArena();
+        FastmemArena(const FastmemArena&) = delete;
+        FastmemArena& operator=(const FastmemArena&) = delete;
+
+        // Makes [paddr, paddr + size) readable and writable. The range reads as zeroes afterwards
+        // even if it was committed before, and pages only take up memory once they're touched
+        uint8_t* Commit(uint32_t paddr, size_t size);
+
+        // Makes a committed range inaccessible again
+        void Decommit(uint32_t paddr, size_t size);
+
+        // Maps the first size bytes of a file copy-on-write at paddr, so pages are only read from
+        // disk when touched. Returns false if the file couldn't be mapped, in which case the range
+        // is left as it was
+        bool MapFile(uint32_t paddr, const std::string& path, size_t size);
+
+        uint8_t* Base() const
+        {
+            return base_;
+        }
+
+    private:
+        struct FreeDeleter
+        {
+            void operator()(uint8_t* ptr) const
+            {
+                std::free(ptr);
+            }
+        };
+
+        // calloc'd so large ranges stay lazily allocated like the arena's pages
+        struct FallbackRange
+        {
+            uint32_t paddr;
+            size_t size;
+            std::unique_ptr<uint8_t[], FreeDeleter> data;
+        };
+
+        uint8_t* base_ = nullptr;
+        std::vector<FallbackRange> fallback_;
+    };
+} // namespace hydra::N64
@@ -1,19 +1,18 @@
+#include <algorithm>
 #include <chrono>
 #include <iostream>
+#include <n64/core/n64_cpu_jit.hxx>
 #include <n64/core/n64_impl.hxx>
-
-// TODO: cmake option
-// #define PROFILING
-#ifdef PROFILING
-#include <valgrind/callgrind.h>
-#else
-#define CALLGRIND_START_INSTRUMENTATION
-#define CALLGRIND_STOP_INSTRUMENTATION
-#endif
+#include <n64/core/n64_profiler.hxx>
 
 namespace hydra::N64
 {
-    N64::N64() : cpubus_(rcp_), cpu_(cpubus_, rcp_) {}
+    N64::N64() : cpubus_(rcp_), cpu_(cpubus_, rcp_, scheduler_)
+    {
+        scheduler_.SetEventCallback(SchedulerEventType::VI, std::bind(&N64::vi_event, this));
+        scheduler_.SetEventCallback(SchedulerEventType::AI, std::bind(&N64::ai_event, this));
+        scheduler_.SetEventCallback(SchedulerEventType::RSP, std::bind(&N64::rsp_event, this));
+    }
 
     bool N64::LoadCartridge(std::string path)
     {
@@ -32,51 +31,163 @@ namespace hydra::N64
         return false;
     }
 
+    void N64::SetFastmem([[maybe_unused]] bool enabled)
+    {
+#ifdef HYDRA_N64_JIT
+        cpu_.jit_->SetFastmem(enabled);
+#endif
+    }
+
+    void N64::SetFrameskip(int frames)
+    {
+        frameskip_ = std::max(frames, 0);
+        frameskip_counter_ = 0;
+        // Also gives frameskip another chance after a skipped frame was read back
+        rcp_.rdp_.ClearSkipped();
+        if (frameskip_ == 0)
+        {
+            rcp_.rdp_.SetSkipDrawing(false);
+        }
+    }
+
     void N64::RunFrame()
     {
-        CALLGRIND_START_INSTRUMENTATION;
-        static int cycles = 0;
-        for (int f = 0; f < 1; f++)
-        { // fields
-            for (int hl = 0; hl < cpu_.rcp_.vi_.num_halflines_; hl++)
-            { // halflines
-                cpu_.rcp_.vi_.vi_v_current_ = (hl << 1) + f;
-                cpu_.check_vi_interrupt();
-                while (cycles <= cpu_.rcp_.vi_.cycles_per_halfline_)
-                {
-                    static int cpu_cycles = 0;
-                    cpu_cycles++;
-                    cpu_.Tick();
-                    rcp_.ai_.Step();
-                    if (!cpu_.rcp_.rsp_.IsHalted())
-                    {
-                        while (cpu_cycles > 2)
-                        {
-                            cpu_.rcp_.rsp_.Tick();
-                            if (!cpu_.rcp_.rsp_.IsHalted())
-                            {
-                                cpu_.rcp_.rsp_.Tick();
-                            }
-                            cpu_cycles -= 3;
-                        }
-                    }
-                    else
-                    {
-                        cpu_cycles = 0;
-                    }
-                    cycles++;
-                }
-                cycles -= cpu_.rcp_.vi_.cycles_per_halfline_;
+        N64_PROFILE_BEGIN_FRAME();
+        if (frameskip_ != 0)
+        {
+            frame_skipped_ = frameskip_counter_ != 0;
+            frameskip_counter_ = (frameskip_counter_ + 1) % (frameskip_ + 1);
+            rcp_.rdp_.SetSkipDrawing(frame_skipped_);
+        }
+        else
+        {
+            frame_skipped_ = false;
+        }
+        [[maybe_unused]] uint64_t start_time = scheduler_.GetTime();
+        cpu_.EnterHostFpEnvironment();
+        frame_finished_ = false;
+        while (!frame_finished_)
+        {
+#ifdef HYDRA_N64_JIT
+            // Blocks may overshoot the next event by a few cycles, it gets serviced right after
+            while (!scheduler_.ShouldService())
+            {
+                scheduler_.Advance(cpu_.jit_->Run());
             }
-            cpu_.check_vi_interrupt();
+#else
+            while (!scheduler_.ShouldService())
+            {
+                cpu_.Tick();
+                scheduler_.Tick();
+            }
+#endif
+            scheduler_.ServiceEvents();
         }
-        CALLGRIND_STOP_INSTRUMENTATION;
+        cpu_.ExitHostFpEnvironment();
+        N64_PROFILE_COUNT(CpuInstructions, scheduler_.GetTime() - start_time);
+        N64_PROFILE_END_FRAME();
     }
 
     void N64::Reset()
     {
+        rcp_.rsp_.Sync();
+        rcp_.rdp_.Flush();
+        scheduler_.Reset();
         cpu_.Reset();
         rcp_.Reset();
+        halfline_ = 0;
+        rcp_.vi_.vi_v_current_ = 0;
+        scheduler_.Schedule(SchedulerEventType::VI, rcp_.vi_.cycles_per_halfline_);
+        scheduler_.Schedule(SchedulerEventType::AI, rcp_.ai_.ai_period_);
+    }
+
+    bool N64::SaveState(std::vector<uint8_t>& buffer)
+    {
+        // Threaded RSP batches and queued RDP commands have to land before memory is copied
+        rcp_.rsp_.Sync();
+        rcp_.rdp_.Flush();
+        StateWriter writer(buffer, SAVE_STATE_MAGIC, SAVE_STATE_VERSION);
+        scheduler_.SaveState(writer);
+        cpubus_.SaveState(writer);
+        cpu_.SaveState(writer);
+        rcp_.rsp_.SaveState(writer);
+        rcp_.rdp_.SaveState(writer);
+        rcp_.vi_.SaveState(writer);
+        rcp_.ai_.SaveState(writer);
+        writer.Write(halfline_);
+        return true;
+    }
+
+    bool N64::LoadState(std::span<const uint8_t> state)
+    {
+        StateReader reader(state, SAVE_STATE_MAGIC, SAVE_STATE_VERSION);
+        if (!reader.Good())
+        {
+            Logger::Warn("Save state is not from this version of the N64 core");
+            return false;
+        }
+
+        rcp_.rsp_.Sync();
+        rcp_.rdp_.Flush();
+        scheduler_.LoadState(reader);
+        cpubus_.LoadState(reader);
+        cpu_.LoadState(reader);
+        rcp_.rsp_.LoadState(reader);
+        rcp_.rdp_.LoadState(reader);
+        rcp_.vi_.LoadState(reader);
+        rcp_.ai_.LoadState(reader);
+        reader.Read(halfline_);
+        if (!reader.Good() || !reader.AtEnd())
+        {
+            // Part of the state was already overwritten, start over instead of running a mix
+            Logger::Warn("Save state is truncated or corrupt, resetting");
+            Reset();
+            return false;
+        }
+        return true;
+    }
+
+    void N64::vi_event()
+    {
+        Vi& vi = rcp_.vi_;
+        if (++halfline_ >= vi.num_halflines_)
+        {
+            halfline_ = 0;
+            frame_finished_ = true;
+        }
+        vi.vi_v_current_ = halfline_ << 1;
+        cpu_.check_vi_interrupt();
+        scheduler_.ScheduleFromDeadline(SchedulerEventType::VI, vi.cycles_per_halfline_);
+    }
+
+    void N64::ai_event()
+    {
+        rcp_.ai_.Step();
+        scheduler_.ScheduleFromDeadline(SchedulerEventType::AI, rcp_.ai_.ai_period_);
+    }
+
+    void N64::rsp_event()
+    {
+        RSP& rsp = rcp_.rsp_;
+        if (rsp.IsThreaded())
+        {
+            // The batch runs alongside the CPU and is joined when this event comes back around,
+            // or earlier if the CPU touches SP/DP registers or SP memory
+            rsp.Sync();
+            if (!rsp.IsHalted())
+            {
+                rsp.RunAsync(RSP_TASK_BUDGET);
+                scheduler_.Schedule(SchedulerEventType::RSP, RSP_TASK_BUDGET * 3 / 2);
+            }
+            return;
+        }
+
+        uint64_t executed = rsp.Run(RSP_TASK_BUDGET);
+        if (!rsp.IsHalted())
+        {
+            // 2 RSP cycles per 3 CPU cycles
+            scheduler_.Schedule(SchedulerEventType::RSP, executed * 3 / 2);
+        }
     }
 
     void N64::SetMousePos(int32_t x, int32_t y)
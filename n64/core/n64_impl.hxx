@@ -3,10 +3,30 @@
 #include <miniaudio.h>
 #include <n64/core/n64_cpu.hxx>
 #include <n64/core/n64_rcp.hxx>
+#include <n64/core/n64_scheduler.hxx>
+#include <span>
 #include <string>
 
 namespace hydra::N64
 {
+    // Most RSP tasks finish well within this many instructions, so they run to completion in a
+    // single event. Tasks that spin waiting on the CPU give it back control once it runs out
+    constexpr uint64_t RSP_TASK_BUDGET = 0x20000;
+
+    // "HN64" in memory. Bump the version whenever a serialized field is added, removed or reordered
+    constexpr uint32_t SAVE_STATE_MAGIC = 0x3436'4E48;
+    constexpr uint32_t SAVE_STATE_VERSION = 3;
+
+    // Running totals, diff two snapshots to measure a stretch of emulation. Times are host
+    // nanoseconds
+    struct PerfStats
+    {
+        uint64_t cpu_cycles;
+        uint64_t rsp_instructions;
+        uint64_t rsp_time;
+        uint64_t rdp_time;
+    };
+
     class N64
     {
     public:
@@ -15,6 +35,8 @@ namespace hydra::N64
         bool LoadIPL(std::string path);
         void RunFrame();
         void Reset();
+        bool SaveState(std::vector<uint8_t>& buffer);
+        bool LoadState(std::span<const uint8_t> state);
         void SetMousePos(int32_t x, int32_t y);
         void SetAudioCallback(std::function<void(const std::vector<int16_t>&, int)> callback);
 
@@ -38,14 +60,64 @@ namespace hydra::N64
             return rcp_.vi_.height_;
         }
 
-        void RenderVideo(std::vector<uint8_t>& data)
+        // Returns the bytes per pixel of the frame, or 0 for repeats. See Vi::Redraw
+        int RenderVideo(std::vector<uint8_t>& data, bool convert_16bpp = true)
+        {
+            // The RSP may still be feeding the RDP commands that draw to the frame
+            rcp_.rsp_.Sync();
+            rcp_.rdp_.Flush();
+            // A frame drawn while skipping can still get scanned out, like the back buffer after
+            // a skipped frame. Keep showing the last finished frame instead
+            if (rcp_.rdp_.IsSkipped(rcp_.vi_.ScanoutAddress(), rcp_.vi_.ScanoutSize()))
+            {
+                return 0;
+            }
+            return rcp_.vi_.Redraw(data, convert_16bpp);
+        }
+
+        // Off by default so runs stay deterministic
+        void SetRSPThreaded(bool threaded)
+        {
+            rcp_.rsp_.SetThreaded(threaded);
+        }
+
+        void SetRDPThreaded(bool threaded)
         {
-            rcp_.vi_.Redraw(data);
+            rcp_.rdp_.SetThreaded(threaded);
+        }
+
+        // Only affects the recompiler
+        void SetFastmem(bool enabled);
+
+        // Draws one frame out of every frames + 1 and skips the rest, 0 draws them all
+        void SetFrameskip(int frames);
+
+        // Whether the last frame was one of the skipped ones, its picture isn't worth showing
+        bool IsFrameSkipped() const
+        {
+            return frame_skipped_;
+        }
+
+        PerfStats GetPerfStats() const
+        {
+            return {scheduler_.GetTime(), rcp_.rsp_.GetExecuted(), rcp_.rsp_.GetBusyTime(),
+                    rcp_.rdp_.GetBusyTime()};
         }
 
     private:
+        Scheduler scheduler_;
         RCP rcp_;
         CPUBus cpubus_;
         CPU cpu_;
+
+        int halfline_ = 0;
+        bool frame_finished_ = false;
+        int frameskip_ = 0;
+        int frameskip_counter_ = 0;
+        bool frame_skipped_ = false;
+
+        void vi_event();
+        void ai_event();
+        void rsp_event();
     };
 } // namespace hydra::N64
@@ -0,0 +1,293 @@
+#include <chrono>
+#include <deque>
+#include <fmt/format.h>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <n64/core/n64_profiler.hxx>
+#include <n64/core/n64_rdp.hxx>
+#include <ringbuffer.hpp>
+#include <string_view>
+#include <vector>
+
+namespace
+{
+    using hydra::N64::ProfileCounter;
+    using hydra::N64::ProfileZone;
+
+    constexpr size_t COUNTER_COUNT = static_cast<size_t>(ProfileCounter::Count);
+    constexpr size_t FIRST_RDP_COMMAND = static_cast<size_t>(ProfileCounter::RdpCommands);
+    constexpr size_t FIRST_EXCEPTION = static_cast<size_t>(ProfileCounter::Exceptions);
+    // About a minute of frames, and as many zones as fit in ~12MB
+    constexpr size_t MAX_FRAMES = 3600;
+    constexpr size_t MAX_EVENTS = 1 << 19;
+
+    struct ZoneEvent
+    {
+        uint64_t start;
+        uint64_t end;
+        ProfileZone zone;
+    };
+
+    // Written by its own thread only, read by whoever holds mutex
+    struct ThreadQueue
+    {
+        uint32_t tid;
+        jnk0le::Ringbuffer<ZoneEvent, 0x4000, false, 64> events;
+    };
+
+    struct TraceEvent
+    {
+        uint64_t start;
+        uint64_t end;
+        uint32_t tid;
+        ProfileZone zone;
+    };
+
+    struct FrameRecord
+    {
+        uint64_t start;
+        uint64_t end;
+        std::array<uint64_t, COUNTER_COUNT> counters;
+    };
+
+    std::mutex mutex;
+    std::vector<std::unique_ptr<ThreadQueue>> queues;
+    std::deque<TraceEvent> trace;
+    std::deque<FrameRecord> frames;
+    uint64_t frame_start = 0;
+    uint32_t next_tid = 0;
+    const auto origin = std::chrono::steady_clock::now();
+
+    std::string_view zone_name(ProfileZone zone)
+    {
+        switch (zone)
+        {
+            case ProfileZone::Frame:
+                return "Frame";
+            case ProfileZone::RSP:
+                return "RSP";
+            case ProfileZone::RDP:
+                return "RDP";
+            case ProfileZone::VI:
+                return "VI";
+            default:
+                return "Unknown";
+        }
+    }
+
+    std::string_view rdp_command_name(size_t id)
+    {
+        switch (id)
+        {
+#define X(name, opcode, length) \
+    case opcode:                \
+        return #name;
+            RDP_COMMANDS
+#undef X
+            default:
+                return "Unknown";
+        }
+    }
+
+    std::string_view exception_name(size_t code)
+    {
+        switch (code)
+        {
+            case 0:
+                return "Interrupt";
+            case 2:
+                return "TLBMissLoad";
+            case 3:
+                return "TLBMissStore";
+            case 4:
+                return "AddressErrorLoad";
+            case 5:
+                return "AddressErrorStore";
+            case 8:
+                return "Syscall";
+            case 9:
+                return "Breakpoint";
+            case 10:
+                return "ReservedInstruction";
+            case 11:
+                return "CoprocessorUnusable";
+            case 12:
+                return "IntegerOverflow";
+            case 13:
+                return "Trap";
+            case 15:
+                return "FloatingPoint";
+            default:
+                return "Unknown";
+        }
+    }
+
+    // Counter groups become one counter track each, skipping entries that never fired
+    void write_counter_track(std::ofstream& out, const FrameRecord& frame, std::string_view name,
+                             size_t first, size_t count, std::string_view (*entry_name)(size_t))
+    {
+        std::string args;
+        for (size_t i = 0; i < count; i++)
+        {
+            uint64_t value = frame.counters[first + i];
+            if (value != 0)
+            {
+                args += fmt::format("{}\"{}\":{}", args.empty() ? "" : ",", entry_name(i), value);
+            }
+        }
+        out << fmt::format(",\n{{\"name\":\"{}\",\"ph\":\"C\",\"ts\":{:.3f},\"pid\":1,"
+                           "\"args\":{{{}}}}}",
+                           name, frame.start / 1000.0, args);
+    }
+
+    void drain_queues()
+    {
+        for (auto& queue : queues)
+        {
+            ZoneEvent event;
+            while (queue->events.remove(event))
+            {
+                trace.push_back({event.start, event.end, queue->tid, event.zone});
+            }
+        }
+        while (trace.size() > MAX_EVENTS)
+        {
+            trace.pop_front();
+        }
+    }
+
+    // Worker threads are recreated on every game load, so each one hands its queue back when it
+    // exits instead of leaving it behind for good
+    struct ThreadQueueOwner
+    {
+        ThreadQueue* queue = nullptr;
+
+        ~ThreadQueueOwner()
+        {
+            if (!queue)
+            {
+                return;
+            }
+
+            std::lock_guard<std::mutex> lock(mutex);
+            drain_queues();
+            std::erase_if(queues, [this](const auto& owned) { return owned.get() == queue; });
+        }
+    };
+
+    thread_local ThreadQueueOwner thread_queue;
+} // namespace
+
+namespace hydra::N64
+{
+    std::array<std::atomic<uint64_t>, COUNTER_COUNT> Profiler::counters_{};
+
+    uint64_t Profiler::Now()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now() - origin)
+            .count();
+    }
+
+    void Profiler::Record(ProfileZone zone, uint64_t start, uint64_t end)
+    {
+        ThreadQueue* queue = thread_queue.queue;
+        if (!queue) [[unlikely]]
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            queue = queues.emplace_back(std::make_unique<ThreadQueue>()).get();
+            queue->tid = ++next_tid;
+            thread_queue.queue = queue;
+        }
+
+        // Dropped if no frame has ended in a while, like when the RDP thread runs a long backlog
+        queue->events.insert({start, end, zone});
+    }
+
+    void Profiler::BeginFrame()
+    {
+        frame_start = Now();
+    }
+
+    void Profiler::EndFrame()
+    {
+        uint64_t end = Now();
+        Record(ProfileZone::Frame, frame_start, end);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        drain_queues();
+        FrameRecord& frame = frames.emplace_back();
+        frame.start = frame_start;
+        frame.end = end;
+        for (size_t i = 0; i < COUNTER_COUNT; i++)
+        {
+            frame.counters[i] = counters_[i].exchange(0, std::memory_order_relaxed);
+        }
+        while (frames.size() > MAX_FRAMES)
+        {
+            frames.pop_front();
+        }
+    }
+
+    bool Profiler::WriteChromeTrace(const std::string& path)
+    {
+        std::ofstream out(path, std::ios::trunc);
+        if (!out.good())
+        {
+            return false;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        drain_queues();
+        out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+        out << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"N64\"}}";
+        for (const TraceEvent& event : trace)
+        {
+            out << fmt::format(",\n{{\"name\":\"{}\",\"ph\":\"X\",\"ts\":{:.3f},\"dur\":{:.3f},"
+                               "\"pid\":1,\"tid\":{}}}",
+                               zone_name(event.zone), event.start / 1000.0,
+                               (event.end - event.start) / 1000.0, event.tid);
+        }
+
+        for (const FrameRecord& frame : frames)
+        {
+            const auto& c = frame.counters;
+            auto at = [&c](ProfileCounter counter) { return c[static_cast<size_t>(counter)]; };
+            out << fmt::format(
+                ",\n{{\"name\":\"Instructions\",\"ph\":\"C\",\"ts\":{:.3f},\"pid\":1,"
+                "\"args\":{{\"CPU\":{},\"RSP\":{}}}}}",
+                frame.start / 1000.0, at(ProfileCounter::CpuInstructions),
+                at(ProfileCounter::RspInstructions));
+            out << fmt::format(
+                ",\n{{\"name\":\"Rasterizer\",\"ph\":\"C\",\"ts\":{:.3f},\"pid\":1,"
+                "\"args\":{{\"Triangles\":{},\"Pixels\":{}}}}}",
+                frame.start / 1000.0, at(ProfileCounter::RdpTriangles),
+                at(ProfileCounter::RdpPixels));
+            out << fmt::format(
+                ",\n{{\"name\":\"DMA bytes\",\"ph\":\"C\",\"ts\":{:.3f},\"pid\":1,"
+                "\"args\":{{\"PI\":{},\"SI\":{},\"SP\":{},\"AI\":{}}}}}",
+                frame.start / 1000.0, at(ProfileCounter::PiDmaBytes),
+                at(ProfileCounter::SiDmaBytes), at(ProfileCounter::SpDmaBytes),
+                at(ProfileCounter::AiDmaBytes));
+            write_counter_track(out, frame, "RDP commands", FIRST_RDP_COMMAND,
+                                FIRST_EXCEPTION - FIRST_RDP_COMMAND, rdp_command_name);
+            write_counter_track(out, frame, "Exceptions", FIRST_EXCEPTION,
+                                COUNTER_COUNT - FIRST_EXCEPTION, exception_name);
+        }
+        out << "\n]}\n";
+        return out.good();
+    }
+
+    void Profiler::Clear()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        drain_queues();
+        trace.clear();
+        frames.clear();
+        for (auto& counter : counters_)
+        {
+            counter.store(0, std::memory_order_relaxed);
+        }
+    }
+} // namespace hydra::N64
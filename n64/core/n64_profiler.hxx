@@ -0,0 +1,106 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+// Instrumentation for finding out where a frame's time went. Everything compiles away unless
+// HYDRA_N64_PROFILER is defined
+#ifdef HYDRA_N64_PROFILER
+#define N64_PROFILE_CONCAT_IMPL(a, b) a##b
+#define N64_PROFILE_CONCAT(a, b) N64_PROFILE_CONCAT_IMPL(a, b)
+#define N64_PROFILE_SCOPE(zone)                                         \
+    ::hydra::N64::ProfileScope N64_PROFILE_CONCAT(profile_scope_, __LINE__)( \
+        ::hydra::N64::ProfileZone::zone)
+#define N64_PROFILE_COUNT(counter, amount) \
+    ::hydra::N64::Profiler::Count(::hydra::N64::ProfileCounter::counter, amount)
+// For counter groups indexed by an RDP command id or exception code
+#define N64_PROFILE_COUNT_AT(counter, index, amount)                                      \
+    ::hydra::N64::Profiler::Count(                                                        \
+        static_cast<::hydra::N64::ProfileCounter>(                                        \
+            static_cast<uint32_t>(::hydra::N64::ProfileCounter::counter) + (index)),      \
+        amount)
+#define N64_PROFILE_BEGIN_FRAME() ::hydra::N64::Profiler::BeginFrame()
+#define N64_PROFILE_END_FRAME() ::hydra::N64::Profiler::EndFrame()
+#else
+#define N64_PROFILE_SCOPE(zone)
+#define N64_PROFILE_COUNT(counter, amount)
+#define N64_PROFILE_COUNT_AT(counter, index, amount)
+#define N64_PROFILE_BEGIN_FRAME()
+#define N64_PROFILE_END_FRAME()
+#endif
+
+namespace hydra::N64
+{
+    enum class ProfileZone : uint8_t
+    {
+        Frame,
+        RSP,
+        RDP,
+        VI,
+        Count
+    };
+
+    enum class ProfileCounter : uint32_t
+    {
+        CpuInstructions,
+        RspInstructions,
+        RdpTriangles,
+        RdpPixels,
+        PiDmaBytes,
+        SiDmaBytes,
+        SpDmaBytes,
+        AiDmaBytes,
+        // One per RDP command id
+        RdpCommands,
+        // One per exception code
+        Exceptions = RdpCommands + 64,
+        Count = Exceptions + 32,
+    };
+
+    // Counters are shared atomics and timed zones go into a lock-free queue per thread, so the
+    // RSP, RDP and rasterizer threads never wait on each other to record. Once per frame the
+    // emulation thread drains the queues and snapshots the counters into a bounded history that
+    // can be written out as a Chrome trace (chrome://tracing or ui.perfetto.dev)
+    class Profiler final
+    {
+    public:
+        Profiler() = delete;
+
+        static void Count(ProfileCounter counter, uint64_t amount)
+        {
+            counters_[static_cast<size_t>(counter)].fetch_add(amount, std::memory_order_relaxed);
+        }
+
+        // Nanoseconds since the profiler started
+        static uint64_t Now();
+        static void Record(ProfileZone zone, uint64_t start, uint64_t end);
+        static void BeginFrame();
+        static void EndFrame();
+        static bool WriteChromeTrace(const std::string& path);
+        static void Clear();
+
+    private:
+        static std::array<std::atomic<uint64_t>, static_cast<size_t>(ProfileCounter::Count)>
+            counters_;
+    };
+
+    class ProfileScope final
+    {
+    public:
+        ProfileScope(ProfileZone zone) : zone_(zone), start_(Profiler::Now()) {}
+
+        ~ProfileScope()
+        {
+            Profiler::Record(zone_, start_, Profiler::Now());
+        }
+
+        ProfileScope(const ProfileScope&) = delete;
+        ProfileScope& operator=(const ProfileScope&) = delete;
+
+    private:
+        ProfileZone zone_;
+        uint64_t start_;
+    };
+} // namespace hydra::N64
@@ -34,5 +34,6 @@ namespace hydra::N64
         friend class hydra::N64::N64;
         friend class hydra::N64::CPUBus;
         friend class hydra::N64::CPU;
+        friend class hydra::N64::CPUJit;
     };
 } // namespace hydra::N64
@@ -2,18 +2,25 @@
 #include <bit>
 #include <bitset>
 #include <cassert>
+#include <chrono>
 #include <compatibility.hxx>
-#include <execution>
 #include <fstream>
 #include <functional>
 #include <iostream>
 #include <log.hxx>
 #include <n64/core/n64_addresses.hxx>
+#include <n64/core/n64_profiler.hxx>
 #include <n64/core/n64_rdp.hxx>
 #include <n64/core/n64_rdp_commands.hxx>
 #include <sstream>
 #include <str_hash.hxx>
 
+// The longest command, TriangleShadeTextureDepth
+constexpr size_t MAX_COMMAND_LENGTH = 22;
+
+// Primitives shorter than this are rendered on the calling thread, waking the workers costs more
+constexpr uint32_t MIN_PARALLEL_ROWS = 16;
+
 hydra_inline static uint32_t irand(uint32_t* state)
 {
     *state = *state * 0x343fd + 0x269ec3;
@@ -90,14 +97,60 @@ namespace hydra::N64
 
     RDP::RDP()
     {
-        rdram_9th_bit_.resize(0x800000);
+        pixel_states_.resize(workers_.WorkerCount());
+        primitive_.spans.reserve(1024);
         init_depth_luts();
     }
 
-    void RDP::InstallBuses(uint8_t* rdram_ptr, uint8_t* spmem_ptr)
+    RDP::~RDP()
+    {
+        SetThreaded(false);
+    }
+
+    void RDP::SetThreaded(bool threaded)
+    {
+        if (threaded == render_thread_.joinable())
+        {
+            return;
+        }
+
+        if (threaded)
+        {
+            if (!command_queue_)
+            {
+                command_queue_ = std::make_unique<CommandQueue>();
+            }
+            render_exit_ = false;
+            render_thread_ = std::thread(&RDP::render_thread_loop, this);
+        }
+        else
+        {
+            Flush();
+            {
+                std::lock_guard<std::mutex> lock(render_mutex_);
+                render_exit_ = true;
+            }
+            render_cv_.notify_all();
+            render_thread_.join();
+        }
+    }
+
+    void RDP::Flush()
+    {
+        if (!render_thread_.joinable())
+        {
+            return;
+        }
+
+        std::unique_lock<std::mutex> lock(render_mutex_);
+        render_cv_.wait(lock, [this] { return completed_ == submitted_; });
+    }
+
+    void RDP::InstallBuses(uint8_t* rdram_ptr, uint8_t* spmem_ptr, Vi* vi_ptr)
     {
         rdram_ptr_ = rdram_ptr;
         spmem_ptr_ = spmem_ptr;
+        vi_ptr_ = vi_ptr;
     }
 
     uint32_t RDP::ReadWord(uint32_t addr)
@@ -180,24 +233,165 @@ namespace hydra::N64
 
     void RDP::Reset()
     {
-        seed_ = 3;
+        Flush();
+        ClearSkipped();
+        queued_color_address_ = 0;
+        queued_color_width_ = 0;
+        queued_color_size_ = 0;
+        queued_z_address_ = 0;
+        queued_rows_ = MAX_SCISSOR_ROWS;
         status_.ready = 1;
-        color_sub_a_[0] = color_sub_a_[1] = &color_one_;
-        color_sub_b_[0] = color_sub_b_[1] = &color_zero_;
-        color_multiplier_[0] = color_multiplier_[1] = &color_one_;
-        color_adder_[0] = color_adder_[1] = &color_zero_;
-        alpha_sub_a_[0] = alpha_sub_a_[1] = &color_zero_;
-        alpha_sub_b_[0] = alpha_sub_b_[1] = &color_zero_;
-        alpha_multiplier_[0] = alpha_multiplier_[1] = &color_one_;
-        alpha_adder_[0] = alpha_adder_[1] = &color_zero_;
+        color_sub_a_[0] = color_sub_a_[1] = One;
+        color_sub_b_[0] = color_sub_b_[1] = Zero;
+        color_multiplier_[0] = color_multiplier_[1] = One;
+        color_adder_[0] = color_adder_[1] = Zero;
+        alpha_sub_a_[0] = alpha_sub_a_[1] = Zero;
+        alpha_sub_b_[0] = alpha_sub_b_[1] = Zero;
+        alpha_multiplier_[0] = alpha_multiplier_[1] = One;
+        alpha_adder_[0] = alpha_adder_[1] = Zero;
         blender_1a_[0] = blender_1a_[1] = 0;
         blender_1b_[0] = blender_1b_[1] = 0;
         blender_2a_[0] = blender_2a_[1] = 0;
         blender_2b_[0] = blender_2b_[1] = 0;
-        texel_color_[0] = texel_color_[1] = 0xFFFFFFFF;
-        texel_alpha_[0] = texel_alpha_[1] = 0xFFFFFFFF;
         cycle_type_ = CycleType::Cycle1;
         perspective_correction_func_ = &no_perspective_correction;
+        update_span_renderer();
+    }
+
+    // Only valid once the render thread is idle, the pending range is empty by then
+    void RDP::SaveState(StateWriter& writer) const
+    {
+        writer.Write(status_);
+        writer.Write(start_address_);
+        writer.Write(end_address_);
+        writer.Write(current_address_);
+        writer.Write(zbuffer_dram_address_);
+        writer.Write(framebuffer_dram_address_);
+        writer.Write(framebuffer_width_);
+        writer.Write(framebuffer_format_);
+        writer.Write(framebuffer_pixel_size_);
+        writer.Write(fill_color_32_);
+        writer.Write(fill_color_16_0_);
+        writer.Write(fill_color_16_1_);
+        writer.Write(blend_color_);
+        writer.Write(fog_color_);
+        writer.Write(primitive_color_);
+        writer.Write(environment_color_);
+        writer.Write(primitive_alpha_);
+        writer.Write(environment_alpha_);
+        writer.Write(fog_alpha_);
+        writer.Write(color_sub_a_);
+        writer.Write(color_sub_b_);
+        writer.Write(color_multiplier_);
+        writer.Write(color_adder_);
+        writer.Write(alpha_sub_a_);
+        writer.Write(alpha_sub_b_);
+        writer.Write(alpha_multiplier_);
+        writer.Write(alpha_adder_);
+        writer.Write(blender_1a_);
+        writer.Write(blender_1b_);
+        writer.Write(blender_2a_);
+        writer.Write(blender_2b_);
+        writer.Write(texture_dram_address_latch_);
+        writer.Write(texture_width_latch_);
+        writer.Write(texture_pixel_size_latch_);
+        writer.Write(texture_format_latch_);
+        writer.Write(tiles_);
+        writer.Write(tmem_);
+        writer.Write(z_update_en_);
+        writer.Write(z_compare_en_);
+        writer.Write(z_source_sel_);
+        writer.Write(image_read_en_);
+        writer.Write(alpha_compare_en_);
+        writer.Write(antialias_en_);
+        writer.Write(color_on_cvg_);
+        writer.Write(cvg_dest_);
+        writer.Write(rdram_9th_bit_.data(), sizeof(rdram_9th_bit_));
+        writer.Write(static_cast<uint8_t>(z_mode_));
+        writer.Write(primitive_depth_);
+        writer.Write(primitive_depth_delta_);
+        writer.Write(scissor_xh_);
+        writer.Write(scissor_yh_);
+        writer.Write(scissor_xl_);
+        writer.Write(scissor_yl_);
+        writer.Write(cycle_type_);
+        writer.Write(queued_color_address_);
+        writer.Write(queued_color_width_);
+        writer.Write(queued_color_size_);
+        writer.Write(queued_z_address_);
+        writer.Write(queued_rows_);
+        writer.Write(perspective_correction_func_ == &perspective_correction);
+    }
+
+    void RDP::LoadState(StateReader& reader)
+    {
+        ClearSkipped();
+        reader.Read(status_);
+        reader.Read(start_address_);
+        reader.Read(end_address_);
+        reader.Read(current_address_);
+        reader.Read(zbuffer_dram_address_);
+        reader.Read(framebuffer_dram_address_);
+        reader.Read(framebuffer_width_);
+        reader.Read(framebuffer_format_);
+        reader.Read(framebuffer_pixel_size_);
+        reader.Read(fill_color_32_);
+        reader.Read(fill_color_16_0_);
+        reader.Read(fill_color_16_1_);
+        reader.Read(blend_color_);
+        reader.Read(fog_color_);
+        reader.Read(primitive_color_);
+        reader.Read(environment_color_);
+        reader.Read(primitive_alpha_);
+        reader.Read(environment_alpha_);
+        reader.Read(fog_alpha_);
+        reader.Read(color_sub_a_);
+        reader.Read(color_sub_b_);
+        reader.Read(color_multiplier_);
+        reader.Read(color_adder_);
+        reader.Read(alpha_sub_a_);
+        reader.Read(alpha_sub_b_);
+        reader.Read(alpha_multiplier_);
+        reader.Read(alpha_adder_);
+        reader.Read(blender_1a_);
+        reader.Read(blender_1b_);
+        reader.Read(blender_2a_);
+        reader.Read(blender_2b_);
+        reader.Read(texture_dram_address_latch_);
+        reader.Read(texture_width_latch_);
+        reader.Read(texture_pixel_size_latch_);
+        reader.Read(texture_format_latch_);
+        reader.Read(tiles_);
+        reader.Read(tmem_);
+        reader.Read(z_update_en_);
+        reader.Read(z_compare_en_);
+        reader.Read(z_source_sel_);
+        reader.Read(image_read_en_);
+        reader.Read(alpha_compare_en_);
+        reader.Read(antialias_en_);
+        reader.Read(color_on_cvg_);
+        reader.Read(cvg_dest_);
+        reader.Read(rdram_9th_bit_.data(), sizeof(rdram_9th_bit_));
+        uint8_t z_mode = 0;
+        reader.Read(z_mode);
+        z_mode_ = z_mode;
+        reader.Read(primitive_depth_);
+        reader.Read(primitive_depth_delta_);
+        reader.Read(scissor_xh_);
+        reader.Read(scissor_yh_);
+        reader.Read(scissor_xl_);
+        reader.Read(scissor_yl_);
+        reader.Read(cycle_type_);
+        reader.Read(queued_color_address_);
+        reader.Read(queued_color_width_);
+        reader.Read(queued_color_size_);
+        reader.Read(queued_z_address_);
+        reader.Read(queued_rows_);
+        bool perspective = false;
+        reader.Read(perspective);
+        perspective_correction_func_ =
+            perspective ? &perspective_correction : &no_perspective_correction;
+        update_span_renderer();
     }
 
     void RDP::SendCommand(const std::vector<uint64_t>& data)
@@ -207,8 +401,12 @@ namespace hydra::N64
 
     void RDP::process_commands()
     {
+        N64_PROFILE_SCOPE(RDP);
         uint32_t current = current_address_ & 0xFFFFF8;
         uint32_t end = end_address_ & 0xFFFFF8;
+        bool threaded = render_thread_.joinable();
+        std::array<uint64_t, MAX_COMMAND_LENGTH> command;
+        auto start = std::chrono::steady_clock::now();
 
         status_.freeze = 1;
         while (current < end)
@@ -221,14 +419,31 @@ namespace hydra::N64
             if (command_type >= 8)
             {
                 int length = get_rdp_command_length(static_cast<RDPCommandType>(command_type));
-                std::vector<uint64_t> command;
-                command.resize(length);
                 for (int i = 0; i < length; i++)
                 {
                     command[i] =
                         hydra::bswap64(*reinterpret_cast<uint64_t*>(address + current + (i * 8)));
                 }
-                execute_command(command);
+
+                // Drawing commands are dropped while skipping frames
+                bool keep = track_command(command.data(), threaded);
+                bool sync_full =
+                    static_cast<RDPCommandType>(command_type) == RDPCommandType::SyncFull;
+                if (keep && !threaded)
+                {
+                    execute_command({command.data(), static_cast<size_t>(length)});
+                }
+                else if (keep && sync_full)
+                {
+                    // SyncFull raises the DP interrupt, so everything before it must be rendered
+                    submit_queued_commands();
+                    Flush();
+                    execute_command({command.data(), static_cast<size_t>(length)});
+                }
+                else if (keep)
+                {
+                    queue_command(command.data(), length);
+                }
                 // Logger::Info("RDP: Command {} ({:02x})",
                 // get_rdp_command_name(static_cast<RDPCommandType>(command_type)),
                 // static_cast<int>(command_type));
@@ -240,14 +455,252 @@ namespace hydra::N64
             }
         }
 
+        if (threaded)
+        {
+            submit_queued_commands();
+        }
+        else
+        {
+            auto elapsed = std::chrono::steady_clock::now() - start;
+            busy_time_.fetch_add(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count(),
+                std::memory_order_relaxed);
+        }
         current_address_ = end_address_;
         status_.freeze = 0;
     }
 
-    void RDP::execute_command(const std::vector<uint64_t>& data)
+    // Follows the color and depth images as commands are read, so the range a command draws to
+    // is known before it gets rendered. Returns false for commands that are dropped
+    bool RDP::track_command(const uint64_t* data, bool threaded)
+    {
+        switch (static_cast<RDPCommandType>((data[0] >> 56) & 0b111111))
+        {
+            case RDPCommandType::SetColorImage:
+            {
+                SetColorImageCommand command;
+                command.full = data[0];
+                queued_color_address_ = command.dram_address;
+                queued_color_width_ = command.width + 1;
+                queued_color_size_ = command.size;
+                color_image_unmarked_ = false;
+                break;
+            }
+            case RDPCommandType::SetZImage:
+            {
+                queued_z_address_ = data[0] & 0x1FFFFFF;
+                break;
+            }
+            case RDPCommandType::SetScissor:
+            {
+                SetScissorCommand command;
+                command.full = data[0];
+                queued_rows_ = (command.YL >> 2) + 1;
+                break;
+            }
+            case RDPCommandType::SetTextureImage:
+            {
+                if (skipped_any_.load(std::memory_order_relaxed))
+                {
+                    SetTextureImageCommand command;
+                    command.full = data[0];
+                    check_skipped(command.DRAMAddress);
+                }
+                break;
+            }
+            case RDPCommandType::Triangle:
+            case RDPCommandType::TriangleDepth:
+            case RDPCommandType::TriangleTexture:
+            case RDPCommandType::TriangleTextureDepth:
+            case RDPCommandType::TriangleShade:
+            case RDPCommandType::TriangleShadeDepth:
+            case RDPCommandType::TriangleShadeTexture:
+            case RDPCommandType::TriangleShadeTextureDepth:
+            case RDPCommandType::Rectangle:
+            case RDPCommandType::TextureRectangle:
+            case RDPCommandType::TextureRectangleFlip:
+            {
+                uint32_t color_row = (queued_color_width_ << queued_color_size_) / 2;
+                vi_ptr_->MarkWritten(queued_color_address_, color_row * queued_rows_);
+                if (skip_drawing_.load(std::memory_order_relaxed) &&
+                    !read_back_.load(std::memory_order_relaxed))
+                {
+                    mark_skipped(queued_color_address_, color_row * queued_rows_, 1);
+                    skipped_any_.store(1, std::memory_order_relaxed);
+                    color_image_unmarked_ = false;
+                    return false;
+                }
+
+                // A drawn frame draws over the whole color image, it's no longer left over from a
+                // skipped one
+                if (!color_image_unmarked_ && skipped_any_.load(std::memory_order_relaxed))
+                {
+                    mark_skipped(queued_color_address_, color_row * queued_rows_, 0);
+                    color_image_unmarked_ = true;
+                }
+
+                if (threaded)
+                {
+                    extend_pending_range(queued_color_address_, color_row * queued_rows_);
+                    extend_pending_range(queued_z_address_,
+                                         queued_color_width_ * 2 * queued_rows_);
+                }
+                break;
+            }
+            default:
+                break;
+        }
+        return true;
+    }
+
+    bool RDP::IsSkipped(uint32_t address, uint32_t size) const
+    {
+        if (size == 0 || !skipped_any_.load(std::memory_order_relaxed))
+        {
+            return false;
+        }
+
+        uint32_t first = address >> SKIPPED_PAGE_SHIFT;
+        uint32_t last = std::min<uint32_t>((address + size - 1) >> SKIPPED_PAGE_SHIFT,
+                                           skipped_pages_.size() - 1);
+        bool skipped = false;
+        for (uint32_t page = first; page <= last; page++)
+        {
+            skipped |= skipped_pages_[page].load(std::memory_order_relaxed) != 0;
+        }
+        return skipped;
+    }
+
+    void RDP::mark_skipped(uint32_t address, uint32_t size, uint8_t skipped)
+    {
+        uint32_t first = address >> SKIPPED_PAGE_SHIFT;
+        uint32_t last = (address + size) >> SKIPPED_PAGE_SHIFT;
+        for (uint32_t page = first; page <= last && page < skipped_pages_.size(); page++)
+        {
+            skipped_pages_[page].store(skipped, std::memory_order_relaxed);
+        }
+    }
+
+    void RDP::check_skipped(uint32_t address, uint32_t size)
+    {
+        if (!IsSkipped(address, size))
+        {
+            return;
+        }
+
+        Logger::Info("Skipped frame was read back, drawing every frame from now on");
+        ClearSkipped();
+        read_back_.store(true, std::memory_order_relaxed);
+    }
+
+    void RDP::ClearSkipped()
+    {
+        read_back_.store(false, std::memory_order_relaxed);
+        skipped_any_.store(0, std::memory_order_relaxed);
+        for (auto& page : skipped_pages_)
+        {
+            page.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    void RDP::queue_command(const uint64_t* data, int length)
+    {
+        // Only whole commands are counted as submitted, so the render thread never sees half of one
+        int remaining = length;
+        while (remaining > 0)
+        {
+            size_t written = command_queue_->writeBuff(data, remaining);
+            data += written;
+            remaining -= written;
+            if (remaining > 0)
+            {
+                // The queue is full, make sure the render thread can see what it needs to drain
+                submit_queued_commands();
+                std::this_thread::yield();
+            }
+        }
+        batch_words_ += length;
+    }
+
+    void RDP::extend_pending_range(uint32_t address, uint32_t size)
+    {
+        batch_start_ = std::min(batch_start_, address);
+        batch_end_ = std::max(batch_end_, address + size);
+    }
+
+    void RDP::submit_queued_commands()
+    {
+        if (batch_words_ == 0)
+        {
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(render_mutex_);
+            submitted_ += batch_words_;
+            uint32_t start = batch_start_;
+            uint32_t end = batch_end_;
+            uint32_t pending_start = pending_start_.load(std::memory_order_relaxed);
+            uint32_t pending_size = pending_size_.load(std::memory_order_relaxed);
+            if (pending_size != 0)
+            {
+                start = std::min(start, pending_start);
+                end = std::max(end, pending_start + pending_size);
+            }
+            if (end > start)
+            {
+                pending_start_.store(start, std::memory_order_relaxed);
+                pending_size_.store(end - start, std::memory_order_relaxed);
+            }
+        }
+        batch_words_ = 0;
+        batch_start_ = UINT32_MAX;
+        batch_end_ = 0;
+        render_cv_.notify_all();
+    }
+
+    void RDP::render_thread_loop()
+    {
+        std::array<uint64_t, MAX_COMMAND_LENGTH> command;
+        std::unique_lock<std::mutex> lock(render_mutex_);
+        while (true)
+        {
+            render_cv_.wait(lock, [this] { return render_exit_ || completed_ < submitted_; });
+            if (completed_ >= submitted_)
+            {
+                return;
+            }
+
+            lock.unlock();
+            uint64_t header = *command_queue_->peek();
+            auto type = static_cast<RDPCommandType>((header >> 56) & 0b111111);
+            size_t length = get_rdp_command_length(type);
+            command_queue_->readBuff(command.data(), length);
+            auto start = std::chrono::steady_clock::now();
+            {
+                N64_PROFILE_SCOPE(RDP);
+                execute_command({command.data(), length});
+            }
+            auto elapsed = std::chrono::steady_clock::now() - start;
+            busy_time_.fetch_add(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count(),
+                std::memory_order_relaxed);
+            lock.lock();
+
+            completed_ += length;
+            if (completed_ == submitted_)
+            {
+                pending_size_.store(0, std::memory_order_relaxed);
+                render_cv_.notify_all();
+            }
+        }
+    }
+
+    void RDP::execute_command(std::span<const uint64_t> data)
     {
         RDPCommandType id = static_cast<RDPCommandType>((data[0] >> 56) & 0b111111);
         // Logger::Info("RDP: {}", get_rdp_command_name(id));
+        N64_PROFILE_COUNT_AT(RdpCommands, static_cast<uint32_t>(id), 1);
         switch (id)
         {
             case RDPCommandType::SyncTile:
@@ -274,6 +727,7 @@ namespace hydra::N64
                 framebuffer_format_ = color_format.format;
                 // 0 = 4bpp, 1 = 8bpp, 2 = 16bpp, 3 = 32bpp
                 framebuffer_pixel_size_ = 4 * (1 << color_format.size);
+                update_span_renderer();
                 break;
             }
             case RDPCommandType::Triangle:
@@ -290,29 +744,30 @@ namespace hydra::N64
                 bool texture = id8 & 0b10;
                 bool shade = id8 & 0b100;
                 EdgewalkerInput input = triangle_get_edgewalker_input(data, shade, texture, depth);
-                Primitive primitive = edgewalker(input);
-                render_primitive(primitive);
+                N64_PROFILE_COUNT(RdpTriangles, 1);
+                edgewalker(input, primitive_);
+                render_primitive(primitive_);
                 break;
             }
             case RDPCommandType::Rectangle:
             {
                 EdgewalkerInput input = rectangle_get_edgewalker_input<false, false>(data);
-                Primitive primitive = edgewalker(input);
-                render_primitive(primitive);
+                edgewalker(input, primitive_);
+                render_primitive(primitive_);
                 break;
             }
             case RDPCommandType::TextureRectangle:
             {
                 EdgewalkerInput input = rectangle_get_edgewalker_input<true, false>(data);
-                Primitive primitive = edgewalker(input);
-                render_primitive(primitive);
+                edgewalker(input, primitive_);
+                render_primitive(primitive_);
                 break;
             }
             case RDPCommandType::TextureRectangleFlip:
             {
                 EdgewalkerInput input = rectangle_get_edgewalker_input<true, true>(data);
-                Primitive primitive = edgewalker(input);
-                render_primitive(primitive);
+                edgewalker(input, primitive_);
+                render_primitive(primitive_);
                 break;
             }
             case RDPCommandType::SetFillColor:
@@ -468,6 +923,7 @@ namespace hydra::N64
                 {
                     perspective_correction_func_ = &no_perspective_correction;
                 }
+                update_span_renderer();
                 break;
             }
             case RDPCommandType::SetPrimDepth:
@@ -565,86 +1021,86 @@ namespace hydra::N64
         }
     }
 
-    uint32_t* RDP::color_get_sub_a(uint8_t sub_a)
+    CombinerInput RDP::color_get_sub_a(uint8_t sub_a)
     {
         switch (sub_a & 0b1111)
         {
             case 0:
-                return &combined_color_;
+                return CombinedColor;
             case 1:
-                return &texel_color_[0];
+                return Texel0Color;
             case 2:
-                return &texel_color_[1];
+                return Texel1Color;
             case 3:
-                return &primitive_color_;
+                return PrimitiveColor;
             case 4:
-                return &shade_color_;
+                return ShadeColor;
             case 5:
-                return &environment_color_;
+                return EnvironmentColor;
             case 6:
-                return &color_one_;
+                return One;
             case 7:
-                return &noise_color_;
+                return NoiseColor;
             default:
-                return &color_zero_;
+                return Zero;
         }
     }
 
-    uint32_t* RDP::color_get_sub_b(uint8_t sub_b)
+    CombinerInput RDP::color_get_sub_b(uint8_t sub_b)
     {
         switch (sub_b & 0b1111)
         {
             case 0:
-                return &combined_color_;
+                return CombinedColor;
             case 1:
-                return &texel_color_[0];
+                return Texel0Color;
             case 2:
-                return &texel_color_[1];
+                return Texel1Color;
             case 3:
-                return &primitive_color_;
+                return PrimitiveColor;
             case 4:
-                return &shade_color_;
+                return ShadeColor;
             case 5:
-                return &environment_color_;
+                return EnvironmentColor;
             // TODO: Key center??
             case 6:
-                return &color_zero_;
+                return Zero;
             // TODO: Convert K4??
             case 7:
-                return &color_zero_;
+                return Zero;
             default:
-                return &color_zero_;
+                return Zero;
         }
     }
 
-    uint32_t* RDP::color_get_mul(uint8_t mul)
+    CombinerInput RDP::color_get_mul(uint8_t mul)
     {
         switch (mul & 0b11111)
         {
             case 0:
-                return &combined_color_;
+                return CombinedColor;
             case 1:
-                return &texel_color_[0];
+                return Texel0Color;
             case 2:
-                return &texel_color_[1];
+                return Texel1Color;
             case 3:
-                return &primitive_color_;
+                return PrimitiveColor;
             case 4:
-                return &shade_color_;
+                return ShadeColor;
             case 5:
-                return &environment_color_;
+                return EnvironmentColor;
             case 7:
-                return &combined_alpha_;
+                return CombinedAlpha;
             case 8:
-                return &texel_alpha_[0];
+                return Texel0Alpha;
             case 9:
-                return &texel_alpha_[1];
+                return Texel1Alpha;
             case 10:
-                return &primitive_alpha_;
+                return PrimitiveAlpha;
             case 11:
-                return &shade_alpha_;
+                return ShadeAlpha;
             case 12:
-                return &environment_alpha_;
+                return EnvironmentAlpha;
             // TODO: rest of the colors
             case 16:
             case 17:
@@ -662,167 +1118,151 @@ namespace hydra::N64
             case 29:
             case 30:
             case 31:
-                return &color_zero_;
+                return Zero;
             default:
                 Logger::WarnOnce("Unhandled mul: {}", mul);
-                return &color_zero_;
+                return Zero;
         }
     }
 
-    uint32_t* RDP::color_get_add(uint8_t add)
+    CombinerInput RDP::color_get_add(uint8_t add)
     {
         switch (add & 0b111)
         {
             case 0:
-                return &combined_color_;
+                return CombinedColor;
             case 1:
-                return &texel_color_[0];
+                return Texel0Color;
             case 2:
-                return &texel_color_[1];
+                return Texel1Color;
             case 3:
-                return &primitive_color_;
+                return PrimitiveColor;
             case 4:
-                return &shade_color_;
+                return ShadeColor;
             case 5:
-                return &environment_color_;
+                return EnvironmentColor;
             case 6:
-                return &color_one_;
+                return One;
             case 7:
-                return &color_zero_;
+                return Zero;
         }
         Logger::Fatal("Unreachable!");
-        return nullptr;
+        return Zero;
     }
 
-    uint32_t* RDP::alpha_get_sub_add(uint8_t sub_a)
+    CombinerInput RDP::alpha_get_sub_add(uint8_t sub_a)
     {
         switch (sub_a & 0b111)
         {
             case 0:
-                return &combined_alpha_;
+                return CombinedAlpha;
             case 1:
-                return &texel_alpha_[0];
+                return Texel0Alpha;
             case 2:
-                return &texel_alpha_[1];
+                return Texel1Alpha;
             case 3:
-                return &primitive_alpha_;
+                return PrimitiveAlpha;
             case 4:
-                return &shade_alpha_;
+                return ShadeAlpha;
             case 5:
-                return &environment_alpha_;
+                return EnvironmentAlpha;
             case 6:
-                return &color_one_;
+                return One;
             default:
-                return &color_zero_;
+                return Zero;
         }
     }
 
-    uint32_t* RDP::alpha_get_mul(uint8_t mul)
+    CombinerInput RDP::alpha_get_mul(uint8_t mul)
     {
         switch (mul & 0b111)
         {
             case 0:
             {
                 Logger::WarnOnce("Unhandled alpha mul: LOD fraction", mul);
-                return &color_one_;
+                return One;
             }
             case 1:
-                return &texel_alpha_[0];
+                return Texel0Alpha;
             case 2:
-                return &texel_alpha_[1];
+                return Texel1Alpha;
             case 3:
-                return &primitive_alpha_;
+                return PrimitiveAlpha;
             case 4:
-                return &shade_alpha_;
+                return ShadeAlpha;
             case 5:
-                return &environment_alpha_;
+                return EnvironmentAlpha;
             case 6:
             {
                 Logger::WarnOnce("Unhandled alpha mul: Primitive LOD fraction", mul);
-                return &color_zero_;
+                return Zero;
             }
             default:
-                return &color_zero_;
+                return Zero;
         }
     }
 
-    void RDP::draw_pixel(int x, int y)
+    template <RDP::CycleType Cycle, bool Rgba16>
+    void RDP::draw_pixel(PixelState& state, int x, int y)
     {
         uintptr_t address = reinterpret_cast<uintptr_t>(rdram_ptr_) + framebuffer_dram_address_ +
                             (y * framebuffer_width_ + x) * (framebuffer_pixel_size_ >> 3);
-        switch (cycle_type_)
+        uint16_t* ptr16 = reinterpret_cast<uint16_t*>(address);
+        uint32_t* ptr32 = reinterpret_cast<uint32_t*>(address);
+        uint32_t color;
+
+        if constexpr (Cycle == CycleType::Fill)
         {
-            case CycleType::Cycle2:
+            if constexpr (Rgba16)
             {
-                color_combiner(0);
-                color_combiner(1);
-                blender(0);
-                // TODO: remove code duplication
-                if (framebuffer_pixel_size_ == 16)
-                {
-                    uint16_t* ptr = reinterpret_cast<uint16_t*>(address);
-                    framebuffer_color_ = rgba16_to_rgba32(hydra::bswap16(*ptr));
-                    *ptr = hydra::bswap16(rgba32_to_rgba16(blender(1)));
-                }
-                else
-                {
-                    uint32_t* ptr = reinterpret_cast<uint32_t*>(address);
-                    framebuffer_color_ = hydra::bswap32(*ptr);
-                    *ptr = hydra::bswap32(blender(1));
-                }
-                break;
+                *ptr16 = hydra::bswap16((x & 1) ? fill_color_16_0_ : fill_color_16_1_);
             }
-            case CycleType::Cycle1:
+            else
             {
-                // TODO: there's may be a way to check which cycle we should get the data from
-                color_combiner(1);
-                if (framebuffer_pixel_size_ == 16)
-                {
-                    uint16_t* ptr = reinterpret_cast<uint16_t*>(address);
-                    framebuffer_color_ = rgba16_to_rgba32(hydra::bswap16(*ptr));
-                    *ptr = hydra::bswap16(rgba32_to_rgba16(blender(0)));
-                }
-                else
-                {
-                    uint32_t* ptr = reinterpret_cast<uint32_t*>(address);
-                    framebuffer_color_ = hydra::bswap32(*ptr);
-                    *ptr = hydra::bswap32(blender(0));
-                }
-                break;
+                *ptr32 = hydra::bswap32(fill_color_32_);
             }
-            case CycleType::Copy:
+            return;
+        }
+        else if constexpr (Cycle == CycleType::Copy)
+        {
+            if (alpha_compare_en_ && state.inputs[Texel0Alpha] == 0)
             {
-                if (alpha_compare_en_ && texel_alpha_[0] == 0)
-                {
-                    break;
-                }
+                return;
+            }
+            color = state.inputs[Texel0Color];
+        }
+        else
+        {
+            if constexpr (Cycle == CycleType::Cycle2)
+            {
+                color_combiner(state, 0);
+                color_combiner(state, 1);
+                blender(state, 0);
+            }
+            else
+            {
+                // TODO: there's may be a way to check which cycle we should get the data from
+                color_combiner(state, 1);
+            }
 
-                if (framebuffer_pixel_size_ == 16)
-                {
-                    uint16_t* ptr = reinterpret_cast<uint16_t*>(address);
-                    *ptr = hydra::bswap16(rgba32_to_rgba16(texel_color_[0]));
-                }
-                else
-                {
-                    uint32_t* ptr = reinterpret_cast<uint32_t*>(address);
-                    *ptr = hydra::bswap32(texel_color_[0]);
-                }
-                break;
+            if constexpr (Rgba16)
+            {
+                state.framebuffer_color = rgba16_to_rgba32(hydra::bswap16(*ptr16));
             }
-            case CycleType::Fill:
+            else
             {
-                if (framebuffer_pixel_size_ == 16)
-                {
-                    uint16_t* ptr = reinterpret_cast<uint16_t*>(address);
-                    *ptr = hydra::bswap16((x & 1) ? fill_color_16_0_ : fill_color_16_1_);
-                }
-                else
-                {
-                    uint32_t* ptr = reinterpret_cast<uint32_t*>(address);
-                    *ptr = hydra::bswap32(fill_color_32_);
-                }
-                break;
+                state.framebuffer_color = hydra::bswap32(*ptr32);
             }
+            color = blender(state, Cycle == CycleType::Cycle2 ? 1 : 0);
+        }
+
+        if constexpr (Rgba16)
+        {
+            *ptr16 = hydra::bswap16(rgba32_to_rgba16(color));
+        }
+        else
+        {
+            *ptr32 = hydra::bswap32(color);
         }
     }
 
@@ -832,21 +1272,23 @@ namespace hydra::N64
         return (a - b) * c / 0xFF + d;
     }
 
-    void RDP::color_combiner(int cycle)
+    void RDP::color_combiner(PixelState& state, int cycle)
     {
-        uint8_t r = combine(*color_sub_a_[cycle], *color_sub_b_[cycle], *color_multiplier_[cycle],
-                            *color_adder_[cycle]);
-        uint8_t g = combine(*color_sub_a_[cycle] >> 8, *color_sub_b_[cycle] >> 8,
-                            *color_multiplier_[cycle] >> 8, *color_adder_[cycle] >> 8);
-        uint8_t b = combine(*color_sub_a_[cycle] >> 16, *color_sub_b_[cycle] >> 16,
-                            *color_multiplier_[cycle] >> 16, *color_adder_[cycle] >> 16);
-        uint8_t a = combine(*alpha_sub_a_[cycle], *alpha_sub_b_[cycle], *alpha_multiplier_[cycle],
-                            *alpha_adder_[cycle]);
-        combined_color_ = (a << 24) | (b << 16) | (g << 8) | r;
-        combined_alpha_ = a << 24 | a << 16 | a << 8 | a;
+        const auto& in = state.inputs;
+        uint32_t sub_a = in[color_sub_a_[cycle]];
+        uint32_t sub_b = in[color_sub_b_[cycle]];
+        uint32_t multiplier = in[color_multiplier_[cycle]];
+        uint32_t adder = in[color_adder_[cycle]];
+        uint8_t r = combine(sub_a, sub_b, multiplier, adder);
+        uint8_t g = combine(sub_a >> 8, sub_b >> 8, multiplier >> 8, adder >> 8);
+        uint8_t b = combine(sub_a >> 16, sub_b >> 16, multiplier >> 16, adder >> 16);
+        uint8_t a = combine(in[alpha_sub_a_[cycle]], in[alpha_sub_b_[cycle]],
+                            in[alpha_multiplier_[cycle]], in[alpha_adder_[cycle]]);
+        state.inputs[CombinedColor] = (a << 24) | (b << 16) | (g << 8) | r;
+        state.inputs[CombinedAlpha] = a << 24 | a << 16 | a << 8 | a;
     }
 
-    uint32_t RDP::blender(int cycle)
+    uint32_t RDP::blender(PixelState& state, int cycle)
     {
         uint32_t color1, color2;
         uint8_t multiplier1, multiplier2;
@@ -854,10 +1296,10 @@ namespace hydra::N64
         switch (blender_1a_[cycle] & 0b11)
         {
             case 0:
-                color1 = combined_color_;
+                color1 = state.inputs[CombinedColor];
                 break;
             case 1:
-                color1 = framebuffer_color_;
+                color1 = state.framebuffer_color;
                 break;
             case 2:
                 color1 = blend_color_;
@@ -870,10 +1312,10 @@ namespace hydra::N64
         switch (blender_2a_[cycle] & 0b11)
         {
             case 0:
-                color2 = combined_color_;
+                color2 = state.inputs[CombinedColor];
                 break;
             case 1:
-                color2 = framebuffer_color_;
+                color2 = state.framebuffer_color;
                 break;
             case 2:
                 color2 = blend_color_;
@@ -886,13 +1328,13 @@ namespace hydra::N64
         switch (blender_1b_[cycle] & 0b11)
         {
             case 0:
-                multiplier1 = combined_alpha_ >> 24;
+                multiplier1 = state.inputs[CombinedAlpha] >> 24;
                 break;
             case 1:
                 multiplier1 = fog_alpha_ >> 24;
                 break;
             case 2:
-                multiplier1 = shade_alpha_ >> 24;
+                multiplier1 = state.inputs[ShadeAlpha] >> 24;
                 break;
             case 3:
                 multiplier1 = 0x00;
@@ -905,7 +1347,7 @@ namespace hydra::N64
                 multiplier2 = ~multiplier1;
                 break;
             case 1:
-                multiplier2 = 0x00; //(uint8_t)(((float)old_coverage_ / 8.0f) * 0xFF);
+                multiplier2 = 0x00; //(uint8_t)(((float)state.old_coverage / 8.0f) * 0xFF);
                 break;
             case 2:
                 multiplier2 = 0xFF;
@@ -925,7 +1367,7 @@ namespace hydra::N64
 
         uint8_t r, g, b;
 
-        if ((!color_on_cvg_ || coverage_overflow_) && !zero_multipliers)
+        if ((!color_on_cvg_ || state.coverage_overflow) && !zero_multipliers)
         {
             r = (((color1 >> 0) & 0xFF) * multiplier1 + ((color2 >> 0) & 0xFF) * multiplier2) /
                 (multiplier1 + multiplier2);
@@ -941,13 +1383,13 @@ namespace hydra::N64
             b = (color2 >> 16) & 0xFF;
         }
 
-        // uint8_t r_f = framebuffer_color_ & 0xFF;
-        // uint8_t g_f = (framebuffer_color_ >> 8) & 0xFF;
-        // uint8_t b_f = (framebuffer_color_ >> 16) & 0xFF;
+        // uint8_t r_f = state.framebuffer_color & 0xFF;
+        // uint8_t g_f = (state.framebuffer_color >> 8) & 0xFF;
+        // uint8_t b_f = (state.framebuffer_color >> 16) & 0xFF;
 
-        if (current_coverage_ != 8)
+        if (state.current_coverage != 8)
         {
-            // float cvg = (float)current_coverage_ / 8.0f;
+            // float cvg = (float)state.current_coverage / 8.0f;
             // r = (r * cvg) + (r_f * (1 - cvg));
             // g = (g * cvg) + (g_f * (1 - cvg));
             // b = (b * cvg) + (b_f * (1 - cvg));
@@ -956,7 +1398,8 @@ namespace hydra::N64
         return (0 << 24) | (b << 16) | (g << 8) | r;
     }
 
-    bool RDP::depth_test(int x, int y, int32_t z, int16_t dz)
+    template <bool ZCompare>
+    bool RDP::depth_test(PixelState& state, int x, int y, int32_t z, int16_t dz)
     {
         enum DepthMode
         {
@@ -966,10 +1409,10 @@ namespace hydra::N64
             Decal
         };
 
-        old_coverage_ = coverage_get(x, y);
-        coverage_overflow_ = ((old_coverage_ - 1) + current_coverage_) & 0b1000;
+        state.old_coverage = coverage_get(x, y);
+        state.coverage_overflow = ((state.old_coverage - 1) + state.current_coverage) & 0b1000;
 
-        if (z_compare_en_)
+        if constexpr (ZCompare)
         {
             int32_t old_z = z_get(x, y);
             int16_t old_dz = dz_get(x, y);
@@ -986,7 +1429,7 @@ namespace hydra::N64
             {
                 case Opaque:
                 {
-                    pass = was_max || (coverage_overflow_ ? infront : nearer);
+                    pass = was_max || (state.coverage_overflow ? infront : nearer);
                     break;
                 }
                 case Interpenetrating:
@@ -1028,9 +1471,7 @@ namespace hydra::N64
     {
         uintptr_t address = zbuffer_dram_address_ + (y * framebuffer_width_ + x) * 2;
         uint16_t* ptr = reinterpret_cast<uint16_t*>(rdram_ptr_ + address);
-        bool hidden1 = rdram_9th_bit_[address];
-        bool hidden2 = rdram_9th_bit_[address + 1];
-        uint8_t dz_c = (hydra::bswap16(*ptr) & 0b11) | (hidden1 << 2) | (hidden2 << 3);
+        uint8_t dz_c = (hydra::bswap16(*ptr) & 0b11) | (hidden_bits_get(address) << 2);
         return dz_decompress(dz_c);
     }
 
@@ -1043,8 +1484,43 @@ namespace hydra::N64
         old &= 0xFFFC;
         old |= dz_c & 0b11;
         *ptr = hydra::bswap16(old);
-        rdram_9th_bit_[address] = (dz_c >> 2) & 0b1;
-        rdram_9th_bit_[address + 1] = (dz_c >> 3) & 0b1;
+        hidden_bits_set(address, (dz_c >> 2) & 0b11);
+    }
+
+    // Returns the hidden bits of address and address + 1 in the low two bits
+    uint8_t RDP::hidden_bits_get(uint32_t address)
+    {
+        uint32_t shift = address & 31;
+        uint64_t bits = rdram_9th_bit_[address >> 5].load(std::memory_order_relaxed);
+        if (shift == 31) [[unlikely]]
+        {
+            uint64_t next = rdram_9th_bit_[(address >> 5) + 1].load(std::memory_order_relaxed);
+            bits |= next << 32;
+        }
+        return (bits >> shift) & 0b11;
+    }
+
+    void RDP::hidden_bits_set(uint32_t address, uint8_t bits)
+    {
+        // Only the worker drawing this pixel touches its bits, so they can't change between the
+        // load and the xor, and the xor leaves the bits of other pixels in the word alone
+        auto update = [this](uint32_t index, uint32_t mask, uint32_t value) {
+            std::atomic<uint32_t>& word = rdram_9th_bit_[index];
+            uint32_t changed = (word.load(std::memory_order_relaxed) ^ value) & mask;
+            if (changed != 0)
+            {
+                word.fetch_xor(changed, std::memory_order_relaxed);
+            }
+        };
+
+        uint32_t shift = address & 31;
+        if (shift == 31) [[unlikely]]
+        {
+            update(address >> 5, 1u << 31, static_cast<uint32_t>(bits & 0b1) << 31);
+            update((address >> 5) + 1, 0b1, bits >> 1);
+            return;
+        }
+        update(address >> 5, 0b11u << shift, static_cast<uint32_t>(bits) << shift);
     }
 
     uint8_t RDP::coverage_get(int x, int y)
@@ -1054,10 +1530,8 @@ namespace hydra::N64
         {
             // Get coverage from hidden bits
             uintptr_t address = framebuffer_dram_address_ + (y * framebuffer_width_ + x) * 2;
-            bool bit0 = rdram_9th_bit_[address];
-            bool bit1 = rdram_9th_bit_[address + 1];
             bool bit2 = hydra::bswap16(*reinterpret_cast<uint16_t*>(&rdram_ptr_[address])) & 0b1;
-            coverage = (bit2 << 2) | (bit1 << 1) | bit0;
+            coverage = (bit2 << 2) | hidden_bits_get(address);
         }
         else
         {
@@ -1106,12 +1580,9 @@ namespace hydra::N64
 
         if (framebuffer_pixel_size_ == 16)
         {
-            bool bit0 = coverage & 0b1;
-            bool bit1 = coverage & 0b10;
             bool bit2 = coverage & 0b100;
             uintptr_t address = framebuffer_dram_address_ + (y * framebuffer_width_ + x) * 2;
-            rdram_9th_bit_[address] = bit0;
-            rdram_9th_bit_[address + 1] = bit1;
+            hidden_bits_set(address, coverage & 0b11);
             uint16_t* ptr = reinterpret_cast<uint16_t*>(&rdram_ptr_[address]);
             uint16_t old = hydra::bswap16(*ptr);
             old &= 0xFFFC;
@@ -1186,8 +1657,10 @@ namespace hydra::N64
         return 1 << dz_c;
     }
 
-    void RDP::fetch_texels(int texel, int tile, int32_t s, int32_t t)
+    void RDP::fetch_texels(PixelState& state, int texel, int tile, int32_t s, int32_t t)
     {
+        uint32_t& texel_color = state.inputs[Texel0Color + texel];
+        uint32_t& texel_alpha = state.inputs[Texel0Alpha + texel];
         TileDescriptor& td = tiles_[tile];
         if (td.clamp_s)
         {
@@ -1222,9 +1695,9 @@ namespace hydra::N64
                         uint16_t address = (td.tmem_address + (t * td.line_width) + s * 2) & 0xFFF;
                         uint8_t byte1 = tmem_[address & 0xFFF];
                         uint8_t byte2 = tmem_[(address + 1) & 0xFFF];
-                        texel_color_[texel] = rgba16_to_rgba32((byte1 << 8) | byte2);
-                        uint8_t alpha = texel_color_[texel] >> 24;
-                        texel_alpha_[texel] = (alpha << 24) | (alpha << 16) | (alpha << 8) | alpha;
+                        texel_color = rgba16_to_rgba32((byte1 << 8) | byte2);
+                        uint8_t alpha = texel_color >> 24;
+                        texel_alpha = (alpha << 24) | (alpha << 16) | (alpha << 8) | alpha;
                         break;
                     }
                     case 32:
@@ -1234,8 +1707,8 @@ namespace hydra::N64
                         uint8_t byte2 = tmem_[(address + 1) & 0xFFF];
                         uint8_t byte3 = tmem_[(address + 2) & 0xFFF];
                         uint8_t byte4 = tmem_[(address + 3) & 0xFFF];
-                        texel_color_[texel] = (byte1 << 24) | (byte2 << 16) | (byte3 << 8) | byte4;
-                        texel_alpha_[texel] = (byte1 << 24) | (byte1 << 16) | (byte1 << 8) | byte1;
+                        texel_color = (byte1 << 24) | (byte2 << 16) | (byte3 << 8) | byte4;
+                        texel_alpha = (byte1 << 24) | (byte1 << 16) | (byte1 << 8) | byte1;
                         break;
                     }
                     default:
@@ -1259,8 +1732,8 @@ namespace hydra::N64
                         uint8_t i = ia & 0xE;
                         i = (i << 4) | (i << 1) | (i >> 2);
                         uint8_t a = (ia & 0x1) ? 0xFF : 0;
-                        texel_color_[texel] = (a << 24) | (i << 16) | (i << 8) | i;
-                        texel_alpha_[texel] = (a << 24) | (a << 16) | (a << 8) | a;
+                        texel_color = (a << 24) | (i << 16) | (i << 8) | i;
+                        texel_alpha = (a << 24) | (a << 16) | (a << 8) | a;
                         break;
                     }
                     case 8:
@@ -1269,8 +1742,8 @@ namespace hydra::N64
                         uint8_t ia = tmem_[address & 0xFFF];
                         uint8_t i = (ia >> 4) | (ia & 0xF0);
                         uint8_t a = (ia & 0xF) | (ia << 4);
-                        texel_color_[texel] = (a << 24) | (i << 16) | (i << 8) | i;
-                        texel_alpha_[texel] = (a << 24) | (a << 16) | (a << 8) | a;
+                        texel_color = (a << 24) | (i << 16) | (i << 8) | i;
+                        texel_alpha = (a << 24) | (a << 16) | (a << 8) | a;
                         break;
                     }
                     case 16:
@@ -1282,8 +1755,8 @@ namespace hydra::N64
                         }
                         uint8_t i = tmem_[address & 0xFFF];
                         uint8_t a = tmem_[(address + 1) & 0xFFF];
-                        texel_color_[texel] = (a << 24) | (i << 16) | (i << 8) | i;
-                        texel_alpha_[texel] = (a << 24) | (a << 16) | (a << 8) | a;
+                        texel_color = (a << 24) | (i << 16) | (i << 8) | i;
+                        texel_alpha = (a << 24) | (a << 16) | (a << 8) | a;
                         break;
                     }
                     default:
@@ -1311,16 +1784,16 @@ namespace hydra::N64
                         {
                             i >>= 4;
                         }
-                        texel_color_[texel] = (i << 24) | (i << 16) | (i << 8) | i;
-                        texel_alpha_[texel] = texel_color_[texel];
+                        texel_color = (i << 24) | (i << 16) | (i << 8) | i;
+                        texel_alpha = texel_color;
                         break;
                     }
                     case 8:
                     {
                         uint16_t address = (td.tmem_address + (t * td.line_width) + s) & 0xFFF;
                         uint8_t i = tmem_[address & 0xFFF];
-                        texel_color_[texel] = (i << 24) | (i << 16) | (i << 8) | i;
-                        texel_alpha_[texel] = texel_color_[texel];
+                        texel_color = (i << 24) | (i << 16) | (i << 8) | i;
+                        texel_alpha = texel_color;
                         break;
                     }
                     default:
@@ -1339,10 +1812,10 @@ namespace hydra::N64
         }
     }
 
-    void RDP::get_noise()
+    void RDP::get_noise(PixelState& state)
     {
-        auto r = irand(&seed_);
-        noise_color_ = (r << 24) | (r << 16) | (r << 8) | r;
+        auto r = irand(&state.seed);
+        state.inputs[NoiseColor] = (r << 24) | (r << 16) | (r << 8) | r;
     }
 
     void RDP::load_tile(const LoadTileCommand& command)
@@ -1436,7 +1909,7 @@ namespace hydra::N64
         }
     }
 
-    EdgewalkerInput RDP::triangle_get_edgewalker_input(const std::vector<uint64_t>& data,
+    EdgewalkerInput RDP::triangle_get_edgewalker_input(std::span<const uint64_t> data,
                                                        bool shade, bool texture, bool depth)
     {
         EdgewalkerInput ret;
@@ -1564,7 +2037,7 @@ namespace hydra::N64
     }
 
     template <bool Texture, bool Flip>
-    EdgewalkerInput RDP::rectangle_get_edgewalker_input(const std::vector<uint64_t>& data)
+    EdgewalkerInput RDP::rectangle_get_edgewalker_input(std::span<const uint64_t> data)
     {
         // Rectangles are simply triangles with slopes = 0 in the RDP
         EdgewalkerInput ret;
@@ -1628,10 +2101,9 @@ namespace hydra::N64
         return value | 3;
     }
 
-    Primitive RDP::edgewalker(const EdgewalkerInput& input)
+    void RDP::edgewalker(const EdgewalkerInput& input, Primitive& primitive)
     {
-        Primitive primitive;
-
+        primitive.spans.clear();
         primitive.tile_index = input.tile_index;
 
         int32_t xh = input.xh, xm = input.xm, xl = input.xl;
@@ -1920,7 +2392,7 @@ namespace hydra::N64
                     }
                     current_span.valid = !all_invalid && !all_over && !all_under;
                     current_span.y = integer_y;
-                    primitive.spans[integer_y] = current_span;
+                    primitive.spans.push_back(current_span);
                 }
             }
 
@@ -1939,8 +2411,6 @@ namespace hydra::N64
             x_left += x_left_inc;
             x_right += x_right_inc;
         }
-
-        return primitive;
     }
 
     hydra_inline uint8_t color_clamp(uint16_t color)
@@ -1974,9 +2444,9 @@ namespace hydra::N64
         }
     }
 
-    void RDP::compute_coverage(const Span& span)
+    void RDP::compute_coverage(PixelState& state, const Span& span)
     {
-        std::memset(&coverage_mask_buffer_, 0xFFFF, sizeof(coverage_mask_buffer_));
+        state.coverage_mask_buffer.fill(0xFFFF);
 
         for (int subpixel = 0; subpixel < 4; subpixel++)
         {
@@ -1991,12 +2461,12 @@ namespace hydra::N64
 
             for (int i = span.min_x; i <= current_left_int; i++)
             {
-                coverage_mask_buffer_[i] &= ~(mask << shift);
+                state.coverage_mask_buffer[i] &= ~(mask << shift);
             }
 
             for (int i = span.max_x; i >= current_right_int; i--)
             {
-                coverage_mask_buffer_[i] &= ~(mask << shift);
+                state.coverage_mask_buffer[i] &= ~(mask << shift);
             }
 
             auto current_right_frac = current_right & 0b111;
@@ -2019,111 +2489,187 @@ namespace hydra::N64
 
             if (current_right_int == current_left_int)
             {
-                coverage_mask_buffer_[current_right_int] |= (coverage_left & coverage_right)
-                                                            << shift;
+                state.coverage_mask_buffer[current_right_int] |=
+                    (coverage_left & coverage_right) << shift;
                 continue;
             }
 
-            coverage_mask_buffer_[current_right_int] |= coverage_right << shift;
-            coverage_mask_buffer_[current_left_int] |= coverage_left << shift;
+            state.coverage_mask_buffer[current_right_int] |= coverage_right << shift;
+            state.coverage_mask_buffer[current_left_int] |= coverage_left << shift;
         }
     }
 
     void RDP::render_primitive(const Primitive& primitive)
     {
-        // clang-format off
-        hydra::parallel_for(primitive.spans.begin(), primitive.spans.end(), [this, &primitive](auto&& span) {
-                if (!span.valid)
-                    return;
-                int32_t y = span.y;
-                int32_t x_start = 0, x_inc = 0;
-                int32_t DzDx = primitive.DzDx;
-                int32_t DrDx = primitive.DrDx;
-                int32_t DgDx = primitive.DgDx;
-                int32_t DbDx = primitive.DbDx;
-                int32_t DaDx = primitive.DaDx;
-
-                int32_t DzPix = primitive.DzPix;
-
-                if (z_source_sel_)
+        uint32_t rows = primitive.spans.size();
+        if (rows == 0)
+        {
+            return;
+        }
+
+#ifdef HYDRA_N64_PROFILER
+        uint64_t pixels = 0;
+        for (const Span& span : primitive.spans)
+        {
+            pixels += span.valid ? span.max_x - span.min_x + 1 : 0;
+        }
+        N64_PROFILE_COUNT(RdpPixels, pixels);
+#endif
+
+        // Rows are interleaved between the workers, each rendering every Nth scanline with its
+        // own pipeline state. Spans never share pixels, so the output doesn't depend on timing
+        span_renderer_ptr renderer = span_renderer_;
+        auto render_rows = [this, &primitive, rows, renderer](uint32_t worker, uint32_t stride) {
+            PixelState& state = pixel_states_[worker];
+            state.inputs[PrimitiveColor] = primitive_color_;
+            state.inputs[PrimitiveAlpha] = primitive_alpha_;
+            state.inputs[EnvironmentColor] = environment_color_;
+            state.inputs[EnvironmentAlpha] = environment_alpha_;
+            state.inputs[One] = 0xFFFF'FFFF;
+            state.inputs[Zero] = 0;
+
+            for (uint32_t row = worker; row < rows; row += stride)
+            {
+                const Span& span = primitive.spans[row];
+                if (span.valid)
                 {
-                    DzDx = 0;
-                    DzPix = primitive_depth_delta_;
+                    (this->*renderer)(state, primitive, span);
                 }
+            }
+        };
 
-                int32_t r = span.r;
-                int32_t g = span.g;
-                int32_t b = span.b;
-                int32_t a = span.a;
-                int32_t s = span.s;
-                int32_t t = span.t;
-                int32_t w = span.w;
-                int32_t z = z_source_sel_ ? primitive_depth_ : span.z;
+        uint32_t workers = workers_.WorkerCount();
+        if (workers == 1 || rows < MIN_PARALLEL_ROWS)
+        {
+            render_rows(0, 1);
+            return;
+        }
 
-                if (primitive.right_major)
-                {
-                    x_start = span.min_x;
-                    x_inc = 1;
-                }
-                else
-                {
-                    x_start = span.max_x;
-                    x_inc = -1;
-                }
+        workers_.Run([&render_rows, workers](uint32_t worker) { render_rows(worker, workers); });
+    }
 
-                int32_t x = x_start;
-                int length = span.max_x - span.min_x;
+    template <RDP::CycleType Cycle, bool Rgba16, bool ZCompare, bool ZUpdate, bool Antialias>
+    void RDP::render_span(PixelState& state, const Primitive& primitive, const Span& span)
+    {
+        int32_t y = span.y;
+        int32_t x_start = 0, x_inc = 0;
+        int32_t DzDx = primitive.DzDx;
+        int32_t DrDx = primitive.DrDx;
+        int32_t DgDx = primitive.DgDx;
+        int32_t DbDx = primitive.DbDx;
+        int32_t DaDx = primitive.DaDx;
 
-                compute_coverage(span);
+        int32_t DzPix = primitive.DzPix;
 
-                for (int i = 0; i <= length; i++)
-                {
-                    uint8_t r8 = color_clamp(r >> 16);
-                    uint8_t g8 = color_clamp(g >> 16);
-                    uint8_t b8 = color_clamp(b >> 16);
-                    uint8_t a8 = color_clamp(a >> 16);
+        if (z_source_sel_)
+        {
+            DzDx = 0;
+            DzPix = primitive_depth_delta_;
+        }
 
-                    shade_color_ = (a8 << 24) | (b8 << 16) | (g8 << 8) | r8;
-                    shade_alpha_ = (a8 << 24) | (a8 << 16) | (a8 << 8) | a8;
+        int32_t r = span.r;
+        int32_t g = span.g;
+        int32_t b = span.b;
+        int32_t a = span.a;
+        int32_t s = span.s;
+        int32_t t = span.t;
+        int32_t w = span.w;
+        int32_t z = z_source_sel_ ? primitive_depth_ : span.z;
 
-                    get_noise();
+        if (primitive.right_major)
+        {
+            x_start = span.min_x;
+            x_inc = 1;
+        }
+        else
+        {
+            x_start = span.max_x;
+            x_inc = -1;
+        }
 
-                    int32_t z_cur = z_correct((z >> 10) & 0x3f'ffff);
-                    current_coverage_ =
-                        std::popcount(coverage_mask_buffer_[x & 0x3ff] & 0xa5a5u);
-                    if (depth_test(x, y, z_cur, DzPix))
+        int32_t x = x_start;
+        int length = span.max_x - span.min_x;
+
+        // Anything carried over between pixels starts from the same values on every span, so
+        // which worker renders a span doesn't change the result
+        state.inputs[CombinedColor] = 0;
+        state.inputs[CombinedAlpha] = 0;
+        state.inputs[Texel0Color] = state.inputs[Texel1Color] = 0xFFFF'FFFF;
+        state.inputs[Texel0Alpha] = state.inputs[Texel1Alpha] = 0xFFFF'FFFF;
+        state.seed = y * 0x9E37'79B9u + 3;
+
+        compute_coverage(state, span);
+
+        for (int i = 0; i <= length; i++)
+        {
+            if constexpr (Cycle == CycleType::Cycle1 || Cycle == CycleType::Cycle2)
+            {
+                uint8_t r8 = color_clamp(r >> 16);
+                uint8_t g8 = color_clamp(g >> 16);
+                uint8_t b8 = color_clamp(b >> 16);
+                uint8_t a8 = color_clamp(a >> 16);
+
+                state.inputs[ShadeColor] = (a8 << 24) | (b8 << 16) | (g8 << 8) | r8;
+                state.inputs[ShadeAlpha] = (a8 << 24) | (a8 << 16) | (a8 << 8) | a8;
+
+                get_noise(state);
+            }
+
+            int32_t z_cur = z_correct((z >> 10) & 0x3f'ffff);
+            state.current_coverage =
+                std::popcount(state.coverage_mask_buffer[x & 0x3ff] & 0xa5a5u);
+            if (depth_test<ZCompare>(state, x, y, z_cur, DzPix))
+            {
+                if constexpr (Cycle != CycleType::Fill)
+                {
+                    auto [s_cur, t_cur] = perspective_correction_func_(s, t, w);
+                    fetch_texels(state, 0, primitive.tile_index, s_cur, t_cur);
+                    if constexpr (Cycle != CycleType::Copy)
                     {
-                        auto [s_cur, t_cur] = perspective_correction_func_(s, t, w);
-                        fetch_texels(0, primitive.tile_index, s_cur, t_cur);
-                        fetch_texels(1, primitive.tile_index, s_cur, t_cur);
-
-                        // 0xA5A5 is the checkerboard pattern the N64 uses as it has only
-                        // 3 bits to store coverage
-                        bool cvbit = coverage_mask_buffer_[x & 0x3ff] & 0x8000u;
-                        if (antialias_en_ ? current_coverage_ : cvbit)
-                        {
-                            draw_pixel(x, y);
-                            if (z_update_en_)
-                            {
-                                z_set(x, y, z_cur);
-                                dz_set(x, y, DzPix);
-                            }
-                            coverage_set(x, y, current_coverage_);
-                        }
+                        fetch_texels(state, 1, primitive.tile_index, s_cur, t_cur);
                     }
+                }
 
-                    z += DzDx * x_inc;
-                    r += DrDx * x_inc;
-                    g += DgDx * x_inc;
-                    b += DbDx * x_inc;
-                    a += DaDx * x_inc;
-                    s += primitive.DsDx * x_inc;
-                    t += primitive.DtDx * x_inc;
-                    w += primitive.DwDx * x_inc;
-                    x += x_inc;
+                // 0xA5A5 is the checkerboard pattern the N64 uses as it has only
+                // 3 bits to store coverage
+                bool cvbit = state.coverage_mask_buffer[x & 0x3ff] & 0x8000u;
+                if (Antialias ? state.current_coverage : cvbit)
+                {
+                    draw_pixel<Cycle, Rgba16>(state, x, y);
+                    if constexpr (ZUpdate)
+                    {
+                        z_set(x, y, z_cur);
+                        dz_set(x, y, DzPix);
+                    }
+                    coverage_set(x, y, state.current_coverage);
                 }
             }
-        );
-        // clang-format on
+
+            z += DzDx * x_inc;
+            r += DrDx * x_inc;
+            g += DgDx * x_inc;
+            b += DbDx * x_inc;
+            a += DaDx * x_inc;
+            s += primitive.DsDx * x_inc;
+            t += primitive.DtDx * x_inc;
+            w += primitive.DwDx * x_inc;
+            x += x_inc;
+        }
+    }
+
+    void RDP::update_span_renderer()
+    {
+        // Every combination of the modes render_span is specialized on, indexed by the same key
+        // that is built below
+        static constexpr auto renderers = []<size_t... Keys>(std::index_sequence<Keys...>) {
+            return std::array<span_renderer_ptr, sizeof...(Keys)>{
+                &RDP::render_span<static_cast<CycleType>(Keys & 0b11), (Keys & 0b100) != 0,
+                                  (Keys & 0b1000) != 0, (Keys & 0b10000) != 0,
+                                  (Keys & 0b100000) != 0>...};
+        }(std::make_index_sequence<64>{});
+
+        size_t key = static_cast<size_t>(cycle_type_) | (framebuffer_pixel_size_ == 16) << 2 |
+                     z_compare_en_ << 3 | z_update_en_ << 4 | antialias_en_ << 5;
+        span_renderer_ = renderers[key];
     }
-} // namespace hydra::N64
\ No newline at end of file
+} // namespace hydra::N64
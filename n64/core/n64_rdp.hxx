@@ -1,8 +1,19 @@
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <condition_variable>
 #include <cstring>
 #include <functional>
+#include <memory>
+#include <mutex>
 #include <n64/core/n64_types.hxx>
+#include <n64/core/n64_vi.hxx>
+#include <n64/core/n64_worker_pool.hxx>
+#include <ringbuffer.hpp>
+#include <span>
+#include <state.hxx>
+#include <thread>
 #include <utility>
 #include <vector>
 
@@ -48,6 +59,7 @@ using persp_func_ptr = std::pair<int32_t, int32_t> (*)(int32_t, int32_t, int32_t
 namespace hydra::N64
 {
     class RSP;
+    class CPUJit;
     union LoadTileCommand;
 
     enum class RDPCommandType
@@ -161,7 +173,8 @@ namespace hydra::N64
 
     struct Primitive
     {
-        std::array<Span, 1024> spans{};
+        // One span per scanline from y_start to y_end
+        std::vector<Span> spans;
         int32_t y_start = 0;
         int32_t y_end = 0;
         int32_t DrDx, DgDx, DbDx, DaDx;
@@ -180,11 +193,99 @@ namespace hydra::N64
         Save = 3
     };
 
+    // Values the color combiner can select from, as indices into PixelState::inputs
+    enum CombinerInput : uint8_t
+    {
+        CombinedColor,
+        Texel0Color,
+        Texel1Color,
+        PrimitiveColor,
+        ShadeColor,
+        EnvironmentColor,
+        NoiseColor,
+        CombinedAlpha,
+        Texel0Alpha,
+        Texel1Alpha,
+        PrimitiveAlpha,
+        ShadeAlpha,
+        EnvironmentAlpha,
+        One,
+        Zero,
+        CombinerInputCount
+    };
+
+    // Everything the pixel pipeline writes while rendering a span. Each rasterizer worker owns
+    // one, so spans can be rendered concurrently
+    struct alignas(64) PixelState
+    {
+        std::array<uint32_t, CombinerInputCount> inputs{};
+        uint32_t framebuffer_color = 0;
+        uint32_t current_coverage = 0;
+        uint32_t old_coverage = 0;
+        bool coverage_overflow = false;
+        uint32_t seed = 0;
+        std::array<uint16_t, 1024> coverage_mask_buffer{};
+    };
+
     class RDP final
     {
     public:
         RDP();
-        void InstallBuses(uint8_t* rdram_ptr, uint8_t* spmem_ptr);
+        ~RDP();
+        void InstallBuses(uint8_t* rdram_ptr, uint8_t* spmem_ptr, Vi* vi_ptr);
+        void SetThreaded(bool threaded);
+        void Flush();
+
+        // Anything reading or writing RDRAM behind the RDP's back calls this first, so pending
+        // commands that may still draw to the address get rendered before it is accessed. Only
+        // reads count as reading back a skipped frame
+        void FlushIfPending(uint32_t address, bool write)
+        {
+            if (address - pending_start_.load(std::memory_order_relaxed) <
+                pending_size_.load(std::memory_order_relaxed)) [[unlikely]]
+            {
+                Flush();
+            }
+
+            if (!write && skipped_any_.load(std::memory_order_relaxed)) [[unlikely]]
+            {
+                check_skipped(address);
+            }
+        }
+
+        // Same as above for a DMA touching size bytes starting at address
+        void FlushIfPending(uint32_t address, uint32_t size, bool write)
+        {
+            uint32_t pending_start = pending_start_.load(std::memory_order_relaxed);
+            uint32_t pending_size = pending_size_.load(std::memory_order_relaxed);
+            if (pending_size != 0 &&
+                (address - pending_start < pending_size || pending_start - address < size))
+                [[unlikely]]
+            {
+                Flush();
+            }
+
+            if (!write && skipped_any_.load(std::memory_order_relaxed)) [[unlikely]]
+            {
+                check_skipped(address, size);
+            }
+        }
+
+        // While set, drawing commands are parsed and dropped instead of rendered. Everything
+        // else, including the DP interrupt, still happens. If the CPU or a texture load touches
+        // memory a dropped command would have drawn to, the RDP renders everything from then on
+        void SetSkipDrawing(bool skip)
+        {
+            skip_drawing_.store(skip, std::memory_order_relaxed);
+        }
+
+        // Forgets where dropped commands would have drawn and whether a skipped frame was read
+        // back, for when skipping stops or the emulated state is replaced
+        void ClearSkipped();
+
+        // Whether any of the range was last drawn to by dropped commands, so it doesn't hold a
+        // finished frame
+        bool IsSkipped(uint32_t address, uint32_t size) const;
 
         void SetInterruptCallback(std::function<void(bool)> callback)
         {
@@ -194,14 +295,23 @@ namespace hydra::N64
         uint32_t ReadWord(uint32_t addr);
         void WriteWord(uint32_t addr, uint32_t data);
         void Reset();
+        void SaveState(StateWriter& writer) const;
+        void LoadState(StateReader& reader);
 
         // Used for QA
         void SendCommand(const std::vector<uint64_t>& command);
 
+        // Nanoseconds spent executing commands, on the render thread when it's running
+        uint64_t GetBusyTime() const
+        {
+            return busy_time_.load(std::memory_order_relaxed);
+        }
+
     private:
         RDPStatus status_;
         uint8_t* rdram_ptr_ = nullptr;
         uint8_t* spmem_ptr_ = nullptr;
+        Vi* vi_ptr_ = nullptr;
         uint32_t start_address_;
         uint32_t end_address_;
         uint32_t current_address_;
@@ -217,41 +327,28 @@ namespace hydra::N64
         uint16_t fill_color_16_0_, fill_color_16_1_;
         uint32_t blend_color_;
         uint32_t fog_color_;
-        uint32_t combined_color_;
-        uint32_t shade_color_;
         uint32_t primitive_color_;
-        uint32_t texel_color_[2];
-        uint32_t texel_alpha_[2];
         uint32_t environment_color_;
-        uint32_t framebuffer_color_;
-        uint32_t noise_color_;
 
-        uint32_t combined_alpha_;
         uint32_t primitive_alpha_;
-        uint32_t shade_alpha_;
         uint32_t environment_alpha_;
         uint32_t fog_alpha_;
-        uint32_t current_coverage_;
-        uint32_t old_coverage_;
 
-        uint32_t* color_sub_a_[2];
-        uint32_t* color_sub_b_[2];
-        uint32_t* color_multiplier_[2];
-        uint32_t* color_adder_[2];
+        CombinerInput color_sub_a_[2];
+        CombinerInput color_sub_b_[2];
+        CombinerInput color_multiplier_[2];
+        CombinerInput color_adder_[2];
 
-        uint32_t* alpha_sub_a_[2];
-        uint32_t* alpha_sub_b_[2];
-        uint32_t* alpha_multiplier_[2];
-        uint32_t* alpha_adder_[2];
+        CombinerInput alpha_sub_a_[2];
+        CombinerInput alpha_sub_b_[2];
+        CombinerInput alpha_multiplier_[2];
+        CombinerInput alpha_adder_[2];
 
         uint8_t blender_1a_[2];
         uint8_t blender_1b_[2];
         uint8_t blender_2a_[2];
         uint8_t blender_2b_[2];
 
-        uint32_t color_zero_ = 0;
-        uint32_t color_one_ = 0xFFFF'FFFF;
-
         uint32_t texture_dram_address_latch_;
         uint32_t texture_width_latch_;
         uint32_t texture_pixel_size_latch_;
@@ -259,10 +356,20 @@ namespace hydra::N64
 
         std::array<TileDescriptor, 8> tiles_;
         std::array<uint8_t, 4096> tmem_;
-        std::vector<bool> rdram_9th_bit_;
+        // The hidden 9th bit of every RDRAM byte, packed 32 to a word. Rows drawn by different
+        // workers can share a word, so bits are only ever changed with atomic read-modify-writes
+        static constexpr uint32_t RDRAM_9TH_BIT_WORDS = 0x800000 / 32;
+        std::array<std::atomic<uint32_t>, RDRAM_9TH_BIT_WORDS> rdram_9th_bit_{};
+        // Save states copy the words as they are, no worker is drawing at that point
+        static_assert(std::atomic<uint32_t>::is_always_lock_free &&
+                      sizeof(std::atomic<uint32_t>) == sizeof(uint32_t));
         std::array<uint32_t, 0x4000> z_decompress_lut_;
         std::array<uint32_t, 0x40000> z_compress_lut_;
-        std::array<uint16_t, 1024> coverage_mask_buffer_;
+        // Reused by every primitive so drawing doesn't allocate. Commands are only ever executed
+        // by one thread at a time
+        Primitive primitive_;
+        std::vector<PixelState> pixel_states_;
+        WorkerPool workers_;
         std::function<void(bool)> interrupt_callback_;
 
         bool z_update_en_ = false;
@@ -272,7 +379,6 @@ namespace hydra::N64
         bool alpha_compare_en_ = false;
         bool antialias_en_ = false;
         bool color_on_cvg_ = false;
-        bool coverage_overflow_ = false;
         CoverageMode cvg_dest_ = CoverageMode::Clamp;
         uint8_t z_mode_ : 2 = 0;
         uint32_t primitive_depth_ = 0;
@@ -283,9 +389,13 @@ namespace hydra::N64
         uint16_t scissor_xl_ = 0;
         uint16_t scissor_yl_ = 0;
 
-        uint32_t seed_;
         persp_func_ptr perspective_correction_func_;
 
+        using span_renderer_ptr = void (RDP::*)(PixelState&, const Primitive&, const Span&);
+        // render_span specialized on the current cycle type, color image size and depth/coverage
+        // modes, picked whenever one of those changes
+        span_renderer_ptr span_renderer_ = nullptr;
+
         enum CycleType
         {
             Cycle1,
@@ -294,46 +404,96 @@ namespace hydra::N64
             Fill
         } cycle_type_;
 
-        void process_commands();
-        void execute_command(const std::vector<uint64_t>& data);
-        void draw_triangle(const std::vector<uint64_t>& data);
-        inline void draw_pixel(int x, int y);
-        void color_combiner(int cycle);
-        uint32_t blender(int cycle);
+        // Commands are copied into command_queue_ and rendered on render_thread_. submitted_ and
+        // completed_ count queued and rendered words and are guarded by render_mutex_
+        using CommandQueue = jnk0le::Ringbuffer<uint64_t, 0x10000, false, 64>;
+        std::unique_ptr<CommandQueue> command_queue_;
+        std::thread render_thread_;
+        std::mutex render_mutex_;
+        std::condition_variable render_cv_;
+        uint64_t submitted_ = 0;
+        uint64_t completed_ = 0;
+        bool render_exit_ = false;
+        std::atomic<uint64_t> busy_time_ = 0;
+
+        // The RDRAM range queued commands may write to, as far as the color and depth images tell
+        std::atomic<uint32_t> pending_start_ = 0;
+        std::atomic<uint32_t> pending_size_ = 0;
+        uint32_t queued_color_address_ = 0;
+        uint32_t queued_color_width_ = 0;
+        uint32_t queued_color_size_ = 0;
+        uint32_t queued_z_address_ = 0;
+        // Until a scissor is set, drawing may cover as many rows as the largest one allows
+        static constexpr uint32_t MAX_SCISSOR_ROWS = (0xFFF >> 2) + 1;
+        uint32_t queued_rows_ = MAX_SCISSOR_ROWS;
+        // RDRAM pages that dropped commands would have drawn to
+        static constexpr uint32_t SKIPPED_PAGE_SHIFT = 12;
+        std::array<std::atomic<uint8_t>, (0x800000 >> SKIPPED_PAGE_SHIFT)> skipped_pages_{};
+        std::atomic<uint32_t> skipped_any_ = 0;
+        std::atomic<bool> skip_drawing_ = false;
+        std::atomic<bool> read_back_ = false;
+        // Set once a drawn frame has unmarked the pages of the current color image
+        bool color_image_unmarked_ = false;
+        uint32_t batch_start_ = UINT32_MAX;
+        uint32_t batch_end_ = 0;
+        uint64_t batch_words_ = 0;
 
-        bool depth_test(int x, int y, int32_t z, int16_t dz);
+        void process_commands();
+        bool track_command(const uint64_t* data, bool threaded);
+        void check_skipped(uint32_t address, uint32_t size = 1);
+        void mark_skipped(uint32_t address, uint32_t size, uint8_t skipped);
+        void queue_command(const uint64_t* data, int length);
+        void submit_queued_commands();
+        void extend_pending_range(uint32_t address, uint32_t size);
+        void render_thread_loop();
+        void execute_command(std::span<const uint64_t> data);
+        void draw_triangle(std::span<const uint64_t> data);
+        template <CycleType Cycle, bool Rgba16>
+        void draw_pixel(PixelState& state, int x, int y);
+        void color_combiner(PixelState& state, int cycle);
+        uint32_t blender(PixelState& state, int cycle);
+
+        template <bool ZCompare>
+        bool depth_test(PixelState& state, int x, int y, int32_t z, int16_t dz);
         inline uint32_t z_get(int x, int y);
         inline uint16_t dz_get(int x, int y);
         inline uint8_t coverage_get(int x, int y);
         inline void z_set(int x, int y, uint32_t z);
         inline void dz_set(int x, int y, uint16_t dz);
         inline void coverage_set(int x, int y, uint8_t coverage);
-        void compute_coverage(const Span& span);
+        inline uint8_t hidden_bits_get(uint32_t address);
+        inline void hidden_bits_set(uint32_t address, uint8_t bits);
+        void compute_coverage(PixelState& state, const Span& span);
         inline uint32_t z_compress(uint32_t z);
         inline uint32_t z_decompress(uint32_t z);
         inline uint8_t dz_compress(uint16_t dz);
         inline uint16_t dz_decompress(uint8_t dz);
         void init_depth_luts();
-        void fetch_texels(int texel, int tile, int32_t s, int32_t t);
-        void get_noise();
+        void fetch_texels(PixelState& state, int texel, int tile, int32_t s, int32_t t);
+        void get_noise(PixelState& state);
         void load_tile(const LoadTileCommand& command);
 
-        uint32_t* color_get_sub_a(uint8_t sub_a);
-        uint32_t* color_get_sub_b(uint8_t sub_b);
-        uint32_t* color_get_mul(uint8_t mul);
-        uint32_t* color_get_add(uint8_t add);
-        uint32_t* alpha_get_sub_add(uint8_t sub_a);
-        uint32_t* alpha_get_mul(uint8_t mul);
+        CombinerInput color_get_sub_a(uint8_t sub_a);
+        CombinerInput color_get_sub_b(uint8_t sub_b);
+        CombinerInput color_get_mul(uint8_t mul);
+        CombinerInput color_get_add(uint8_t add);
+        CombinerInput alpha_get_sub_add(uint8_t sub_a);
+        CombinerInput alpha_get_mul(uint8_t mul);
 
-        EdgewalkerInput triangle_get_edgewalker_input(const std::vector<uint64_t>& data, bool shade,
+        EdgewalkerInput triangle_get_edgewalker_input(std::span<const uint64_t> data, bool shade,
                                                       bool texture, bool depth);
 
         template <bool Texture, bool Flip>
-        EdgewalkerInput rectangle_get_edgewalker_input(const std::vector<uint64_t>& data);
+        EdgewalkerInput rectangle_get_edgewalker_input(std::span<const uint64_t> data);
 
-        Primitive edgewalker(const EdgewalkerInput& data);
+        void edgewalker(const EdgewalkerInput& data, Primitive& primitive);
         void render_primitive(const Primitive& primitive);
+        void update_span_renderer();
+
+        template <CycleType Cycle, bool Rgba16, bool ZCompare, bool ZUpdate, bool Antialias>
+        void render_span(PixelState& state, const Primitive& primitive, const Span& span);
 
         friend class hydra::N64::RSP;
+        friend class hydra::N64::CPUJit;
     };
 } // namespace hydra::N64
\ No newline at end of file
@@ -1,56 +1,21 @@
 #include <algorithm>
+#include <chrono>
 #include <compatibility.hxx>
+#include <cstring>
 #include <fmt/format.h>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
 #include <log.hxx>
 #include <n64/core/n64_addresses.hxx>
+#include <n64/core/n64_profiler.hxx>
 #include <n64/core/n64_rdp.hxx>
 #include <n64/core/n64_rsp.hxx>
+#include <n64/core/n64_rsp_simd.hxx>
 #include <sstream>
 
 #define RSP_LOGGING false
 
-bool is_sign_extension(int16_t high, int16_t low)
-{
-    if (high == 0)
-    {
-        return !(low & 0x8000);
-    }
-    else if (high == -1)
-    {
-        return (low & 0x8000);
-    }
-    return false;
-}
-
-int16_t clamp_signed(int64_t value)
-{
-    if (value < -32768)
-    {
-        return -32768;
-    }
-    if (value > 32767)
-    {
-        return 32767;
-    }
-    return value;
-}
-
-int16_t clamp_unsigned(int64_t value)
-{
-    if (value < 0)
-    {
-        return 0;
-    }
-    if (value >= 0x8000)
-    {
-        return 0xFFFF;
-    }
-    return value;
-}
-
 constexpr std::array<uint16_t, 0x200> RCP_TABLE = {
     0xffff, 0xff00, 0xfe01, 0xfd04, 0xfc07, 0xfb0c, 0xfa11, 0xf918, 0xf81f, 0xf727, 0xf631, 0xf53b,
     0xf446, 0xf352, 0xf25f, 0xf16d, 0xf07c, 0xef8b, 0xee9c, 0xedae, 0xecc0, 0xebd3, 0xeae8, 0xe9fd,
@@ -206,6 +171,11 @@ namespace hydra::N64
         status_.halt = true;
     }
 
+    RSP::~RSP()
+    {
+        SetThreaded(false);
+    }
+
     void RSP::Reset()
     {
         status_.full = 0;
@@ -213,7 +183,7 @@ namespace hydra::N64
         mem_.fill(0);
         std::for_each(gpr_regs_.begin(), gpr_regs_.end(), [](auto& reg) { reg.UW = 0; });
         std::for_each(vu_regs_.begin(), vu_regs_.end(), [](auto& reg) { reg.fill(0); });
-        std::for_each(accumulator_.begin(), accumulator_.end(), [](auto& reg) { reg.Set(0); });
+        accumulator_ = {};
         vco_.Clear();
         vce_.Clear();
         vcc_.Clear();
@@ -229,30 +199,270 @@ namespace hydra::N64
         pc_ = 0;
         next_pc_ = 4;
         semaphore_ = false;
+        decoded_imem_ = nullptr;
+        imem_dirty_ = true;
+    }
+
+    void RSP::SaveState(StateWriter& writer) const
+    {
+        writer.Write(mem_);
+        writer.Write(gpr_regs_);
+        writer.Write(vu_regs_);
+        writer.Write(vco_);
+        writer.Write(vcc_);
+        writer.Write(vce_);
+        writer.Write(div_in_);
+        writer.Write(div_out_);
+        writer.Write(div_in_ready_);
+        writer.Write(accumulator_);
+        writer.Write(mem_addr_);
+        writer.Write(dma_imem_);
+        writer.Write(rdram_addr_);
+        writer.Write(rd_len_);
+        writer.Write(wr_len_);
+        writer.Write(status_);
+        writer.Write(pc_);
+        writer.Write(next_pc_);
+        writer.Write(semaphore_);
+    }
+
+    void RSP::LoadState(StateReader& reader)
+    {
+        reader.Read(mem_);
+        reader.Read(gpr_regs_);
+        reader.Read(vu_regs_);
+        reader.Read(vco_);
+        reader.Read(vcc_);
+        reader.Read(vce_);
+        reader.Read(div_in_);
+        reader.Read(div_out_);
+        reader.Read(div_in_ready_);
+        reader.Read(accumulator_);
+        reader.Read(mem_addr_);
+        reader.Read(dma_imem_);
+        reader.Read(rdram_addr_);
+        reader.Read(rd_len_);
+        reader.Read(wr_len_);
+        reader.Read(status_);
+        reader.Read(pc_);
+        reader.Read(next_pc_);
+        reader.Read(semaphore_);
+        invalidate_imem();
     }
 
     void RSP::Tick()
     {
+        if (imem_dirty_) [[unlikely]]
+        {
+            update_decoded_imem();
+        }
+
         gpr_regs_[0].UW = 0;
-        auto instruction = fetch_instruction();
-        instruction_.full = instruction;
+        const DecodedInstruction& decoded = decoded_imem_->code[(pc_ & 0xFFF) >> 2];
+        instruction_ = decoded.instruction;
 
         log_cpu_state<RSP_LOGGING>(true, 10000000);
 
         pc_ = next_pc_ & 0xFFF;
         next_pc_ = (pc_ + 4) & 0xFFF;
-        execute_instruction();
+        decoded.handler(this);
+    }
+
+    uint64_t RSP::Run(uint64_t instructions)
+    {
+        N64_PROFILE_SCOPE(RSP);
+        auto start = std::chrono::steady_clock::now();
+        uint64_t executed = 0;
+        while (executed < instructions && !status_.halt)
+        {
+            Tick();
+            executed++;
+        }
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        busy_time_.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count(),
+                             std::memory_order_relaxed);
+        executed_.fetch_add(executed, std::memory_order_relaxed);
+        N64_PROFILE_COUNT(RspInstructions, executed);
+        return executed;
+    }
+
+    void RSP::RunAsync(uint64_t instructions)
+    {
+        if (!worker_.joinable())
+        {
+            Run(instructions);
+            return;
+        }
+
+        Sync();
+        {
+            std::lock_guard<std::mutex> lock(worker_mutex_);
+            worker_budget_ = instructions;
+            worker_busy_ = true;
+        }
+        batch_in_flight_ = true;
+        worker_cv_.notify_all();
+    }
+
+    void RSP::Sync()
+    {
+        if (!batch_in_flight_) [[likely]]
+        {
+            return;
+        }
+
+        {
+            std::unique_lock<std::mutex> lock(worker_mutex_);
+            worker_cv_.wait(lock, [this] { return !worker_busy_; });
+        }
+        batch_in_flight_ = false;
+
+        std::vector<std::function<void()>> callbacks;
+        callbacks.swap(deferred_callbacks_);
+        for (auto& callback : callbacks)
+        {
+            callback();
+        }
+    }
+
+    void RSP::SetThreaded(bool threaded)
+    {
+        if (threaded == worker_.joinable())
+        {
+            return;
+        }
+
+        if (threaded)
+        {
+            worker_exit_ = false;
+            worker_ = std::thread(&RSP::worker_loop, this);
+        }
+        else
+        {
+            Sync();
+            {
+                std::lock_guard<std::mutex> lock(worker_mutex_);
+                worker_exit_ = true;
+            }
+            worker_cv_.notify_all();
+            worker_.join();
+        }
+    }
+
+    bool RSP::IsThreaded()
+    {
+        return worker_.joinable();
+    }
+
+    void RSP::worker_loop()
+    {
+        std::unique_lock<std::mutex> lock(worker_mutex_);
+        while (true)
+        {
+            worker_cv_.wait(lock, [this] { return worker_busy_ || worker_exit_; });
+            if (worker_exit_)
+            {
+                return;
+            }
+
+            lock.unlock();
+            Run(worker_budget_);
+            lock.lock();
+            worker_busy_ = false;
+            worker_cv_.notify_all();
+        }
+    }
+
+    void RSP::post_callback(std::function<void()> callback)
+    {
+        if (std::this_thread::get_id() == worker_.get_id())
+        {
+            deferred_callbacks_.push_back(std::move(callback));
+        }
+        else
+        {
+            callback();
+        }
+    }
+
+    RSP::DecodedInstruction RSP::decode_instruction(uint32_t instruction)
+    {
+        DecodedInstruction decoded;
+        decoded.instruction.full = instruction;
+        switch (decoded.instruction.IType.op)
+        {
+            case 0x00:
+                decoded.handler = special_table_[decoded.instruction.RType.func];
+                break;
+            case 0x01:
+                decoded.handler = regimm_table_[decoded.instruction.RType.rt];
+                break;
+            case 0x12:
+            {
+                switch (decoded.instruction.WCType.base)
+                {
+                    case 0:
+                    case 2:
+                    case 4:
+                    case 6:
+                        decoded.handler = instruction_table_[0x12];
+                        break;
+                    default:
+                        decoded.handler = vu_instruction_table_[decoded.instruction.FType.func];
+                        break;
+                }
+                break;
+            }
+            default:
+                decoded.handler = instruction_table_[decoded.instruction.IType.op];
+                break;
+        }
+        return decoded;
     }
 
-    void RSP::execute_instruction()
+    void RSP::update_decoded_imem()
     {
-        (instruction_table_[instruction_.IType.op])(this);
+        imem_dirty_ = false;
+        const uint8_t* imem = &mem_[0x1000];
+        uint32_t crc = 0xFFFF'FFFF;
+        for (int i = 0; i < 0x1000; i += 8)
+        {
+            uint64_t data;
+            memcpy(&data, &imem[i], sizeof(uint64_t));
+            crc = hydra::crc32_u64(crc, data);
+        }
+
+        auto it = imem_cache_.find(crc);
+        if (it != imem_cache_.end() && memcmp(it->second->imem.data(), imem, 0x1000) == 0)
+        {
+            decoded_imem_ = it->second.get();
+            return;
+        }
+
+        // A crc collision simply replaces the old decoding
+        if (it == imem_cache_.end())
+        {
+            if (imem_cache_.size() >= MAX_CACHED_IMEMS)
+            {
+                imem_cache_.clear();
+            }
+            it = imem_cache_.emplace(crc, std::make_unique<DecodedIMEM>()).first;
+        }
+
+        DecodedIMEM* cached = it->second.get();
+        memcpy(cached->imem.data(), imem, 0x1000);
+        for (int i = 0; i < 0x400; i++)
+        {
+            uint32_t instruction;
+            memcpy(&instruction, &imem[i * 4], sizeof(uint32_t));
+            cached->code[i] = decode_instruction(hydra::bswap32(instruction));
+        }
+        decoded_imem_ = cached;
     }
 
-    uint32_t RSP::fetch_instruction()
+    void RSP::invalidate_imem()
     {
-        uint32_t instruction = *reinterpret_cast<uint32_t*>(&mem_[0x1000 + (pc_ & 0xFFF)]);
-        return hydra::bswap32(instruction);
+        imem_dirty_ = true;
     }
 
     uint8_t RSP::load_byte(uint16_t address)
@@ -323,9 +533,15 @@ namespace hydra::N64
         auto rsp_index = mem_addr_ & 0xFF8;
         uint8_t* dest = dma_imem_ ? &mem_[0x1000] : &mem_[0];
         uint8_t* source = rdram_ptr_;
+        if (dma_imem_)
+        {
+            invalidate_imem();
+        }
+        N64_PROFILE_COUNT(SpDmaBytes, bytes_per_row * (row_count + 1));
 
         for (uint32_t i = 0; i < row_count + 1; i++)
         {
+            rdp_ptr_->FlushIfPending(rdram_index, bytes_per_row, false);
             for (uint32_t j = 0; j < bytes_per_row; j++)
             {
                 dest[rsp_index++] = source[rdram_index++];
@@ -360,13 +576,22 @@ namespace hydra::N64
         auto rsp_index = mem_addr_ & 0xFF8;
         uint8_t* dest = rdram_ptr_;
         uint8_t* source = dma_imem_ ? &mem_[0x1000] : &mem_[0];
+        N64_PROFILE_COUNT(SpDmaBytes, bytes_per_row * (row_count + 1));
 
         for (uint32_t i = 0; i < row_count + 1; i++)
         {
+            uint32_t row_start = rdram_index;
+            rdp_ptr_->FlushIfPending(rdram_index, bytes_per_row, true);
             for (uint32_t j = 0; j < bytes_per_row; j++)
             {
                 dest[rdram_index++] = source[rsp_index++];
             }
+            if (rdram_write_callback_)
+            {
+                post_callback([this, row_start, bytes_per_row] {
+                    rdram_write_callback_(row_start, bytes_per_row);
+                });
+            }
             rdram_index += row_stride;
             rdram_index &= 0xFFFFF8;
             rsp_index &= 0xFF8;
@@ -440,12 +665,12 @@ namespace hydra::N64
                 sp_write.full = data;
                 if (sp_write.clear_intr && !sp_write.set_intr)
                 {
-                    interrupt_callback_(false);
+                    post_callback([this] { interrupt_callback_(false); });
                 }
                 else if (!sp_write.clear_intr && sp_write.set_intr)
                 {
                     Logger::Debug("Raising SP interrupt");
-                    interrupt_callback_(true);
+                    post_callback([this] { interrupt_callback_(true); });
                 }
                 if (sp_write.clear_broke)
                 {
@@ -581,24 +806,10 @@ namespace hydra::N64
         interrupt_callback_ = callback;
     }
 
-    using Elements = std::array<uint8_t, 8>;
-
-    std::array<Elements, 16> elements = {{{0, 1, 2, 3, 4, 5, 6, 7},
-                                          {0, 1, 2, 3, 4, 5, 6, 7},
-                                          {0, 0, 2, 2, 4, 4, 6, 6},
-                                          {1, 1, 3, 3, 5, 5, 7, 7},
-                                          {0, 0, 0, 0, 4, 4, 4, 4},
-                                          {1, 1, 1, 1, 5, 5, 5, 5},
-                                          {2, 2, 2, 2, 6, 6, 6, 6},
-                                          {3, 3, 3, 3, 7, 7, 7, 7},
-                                          {0, 0, 0, 0, 0, 0, 0, 0},
-                                          {1, 1, 1, 1, 1, 1, 1, 1},
-                                          {2, 2, 2, 2, 2, 2, 2, 2},
-                                          {3, 3, 3, 3, 3, 3, 3, 3},
-                                          {4, 4, 4, 4, 4, 4, 4, 4},
-                                          {5, 5, 5, 5, 5, 5, 5, 5},
-                                          {6, 6, 6, 6, 6, 6, 6, 6},
-                                          {7, 7, 7, 7, 7, 7, 7, 7}}};
+    void RSP::SetRDRAMWriteCallback(std::function<void(uint32_t, uint32_t)> callback)
+    {
+        rdram_write_callback_ = callback;
+    }
 
     VectorRegister& RSP::get_vt()
     {
@@ -1002,111 +1213,120 @@ namespace hydra::N64
         }
     }
 
-    void RSP::VAND()
+    using namespace simd;
+
+    struct AccumulatorPlanes
     {
-        VectorRegister& vd = get_vd();
-        VectorRegister& vs = get_vs();
-        VectorRegister& vt = get_vt();
-        const Elements& e = elements[vuinstr.element];
+        Vector high;
+        Vector middle;
+        Vector low;
+    };
 
-        for (int i = 0; i < 8; i++)
-        {
-            accumulator_[i].SetLow(vs[i] & vt[e[i]]);
-        }
+    static AccumulatorPlanes load_accumulator(const Accumulator& accumulator)
+    {
+        return {load(accumulator.high.data()), load(accumulator.middle.data()),
+                load(accumulator.low.data())};
+    }
 
-        for (int i = 0; i < 8; i++)
-        {
-            vd[i] = accumulator_[i].GetLow();
-        }
+    static void store_accumulator(Accumulator& accumulator, const AccumulatorPlanes& planes)
+    {
+        store(accumulator.high.data(), planes.high);
+        store(accumulator.middle.data(), planes.middle);
+        store(accumulator.low.data(), planes.low);
     }
 
-    void RSP::VNAND()
+    // 48-bit addition carried across the planes. Comparisons return all ones lane masks, so the
+    // carries get added by subtracting them.
+    static AccumulatorPlanes add_accumulator(const AccumulatorPlanes& lhs,
+                                             const AccumulatorPlanes& rhs)
     {
-        VectorRegister& vd = get_vd();
-        VectorRegister& vs = get_vs();
-        VectorRegister& vt = get_vt();
-        const Elements& e = elements[vuinstr.element];
+        Vector low = add(lhs.low, rhs.low);
+        Vector carry_low = lt_unsigned(low, lhs.low);
+        Vector middle_sum = add(lhs.middle, rhs.middle);
+        Vector carry_middle = lt_unsigned(middle_sum, lhs.middle);
+        Vector middle = sub(middle_sum, carry_low);
+        carry_middle = or_(carry_middle, and_(carry_low, eq(middle, zero())));
+        Vector high = sub(add(lhs.high, rhs.high), carry_middle);
+        return {high, middle, low};
+    }
 
-        for (int i = 0; i < 8; i++)
-        {
-            accumulator_[i].SetLow((vs[i] & vt[e[i]]) ^ 0xFFFF);
-        }
+    // Sign extended 32-bit product of a signed and an unsigned vector
+    static AccumulatorPlanes multiply_signed_unsigned(Vector signed_vector, Vector unsigned_vector)
+    {
+        Vector low = mullo(signed_vector, unsigned_vector);
+        Vector middle = sub(mulhi_unsigned(signed_vector, unsigned_vector),
+                            and_(sign(signed_vector), unsigned_vector));
+        return {sign(middle), middle, low};
+    }
 
-        for (int i = 0; i < 8; i++)
-        {
-            vd[i] = accumulator_[i].GetLow();
-        }
+    // Clamps bits 16-47 of the accumulator to an unsigned 16-bit value
+    static Vector clamp_accumulator_unsigned(const AccumulatorPlanes& accumulator)
+    {
+        Vector clamped = clamp_signed(accumulator.high, accumulator.middle);
+        Vector overflow = or_(gt(accumulator.high, zero()),
+                              and_(eq(accumulator.high, zero()), sign(accumulator.middle)));
+        return andnot(sign(accumulator.high), or_(clamped, overflow));
     }
 
-    void RSP::VOR()
+    // Picks the low plane if bits 16-47 are just its sign extension, clamps it otherwise
+    static Vector clamp_accumulator_low(const AccumulatorPlanes& accumulator)
     {
-        VectorRegister& vd = get_vd();
-        VectorRegister& vs = get_vs();
-        VectorRegister& vt = get_vt();
-        const Elements& e = elements[vuinstr.element];
+        Vector fits = eq(accumulator.high, sign(accumulator.middle));
+        return select(fits, accumulator.low, not_(sign(accumulator.high)));
+    }
 
-        for (int i = 0; i < 8; i++)
-        {
-            accumulator_[i].SetLow(vs[i] | vt[e[i]]);
-        }
+    void RSP::VAND()
+    {
+        Vector vs = load(get_vs().data());
+        Vector vt = shuffle(load(get_vt().data()), vuinstr.element);
+        Vector result = and_(vs, vt);
+        store(accumulator_.low.data(), result);
+        store(get_vd().data(), result);
+    }
 
-        for (int i = 0; i < 8; i++)
-        {
-            vd[i] = accumulator_[i].GetLow();
-        }
+    void RSP::VNAND()
+    {
+        Vector vs = load(get_vs().data());
+        Vector vt = shuffle(load(get_vt().data()), vuinstr.element);
+        Vector result = not_(and_(vs, vt));
+        store(accumulator_.low.data(), result);
+        store(get_vd().data(), result);
     }
 
-    void RSP::VNOR()
+    void RSP::VOR()
     {
-        VectorRegister& vd = get_vd();
-        VectorRegister& vs = get_vs();
-        VectorRegister& vt = get_vt();
-        const Elements& e = elements[vuinstr.element];
+        Vector vs = load(get_vs().data());
+        Vector vt = shuffle(load(get_vt().data()), vuinstr.element);
+        Vector result = or_(vs, vt);
+        store(accumulator_.low.data(), result);
+        store(get_vd().data(), result);
+    }
 
-        for (int i = 0; i < 8; i++)
-        {
-            accumulator_[i].SetLow((vs[i] | vt[e[i]]) ^ 0xFFFF);
-        }
-        for (int i = 0; i < 8; i++)
-        {
-            vd[i] = accumulator_[i].GetLow();
-        }
+    void RSP::VNOR()
+    {
+        Vector vs = load(get_vs().data());
+        Vector vt = shuffle(load(get_vt().data()), vuinstr.element);
+        Vector result = not_(or_(vs, vt));
+        store(accumulator_.low.data(), result);
+        store(get_vd().data(), result);
     }
 
     void RSP::VXOR()
     {
-        VectorRegister& vd = get_vd();
-        VectorRegister& vs = get_vs();
-        VectorRegister& vt = get_vt();
-        const Elements& e = elements[vuinstr.element];
-
-        for (int i = 0; i < 8; i++)
-        {
-            accumulator_[i].SetLow(vs[i] ^ vt[e[i]]);
-        }
-
-        for (int i = 0; i < 8; i++)
-        {
-            vd[i] = accumulator_[i].GetLow();
-        }
+        Vector vs = load(get_vs().data());
+        Vector vt = shuffle(load(get_vt().data()), vuinstr.element);
+        Vector result = xor_(vs, vt);
+        store(accumulator_.low.data(), result);
+        store(get_vd().data(), result);
     }
 
     void RSP::VNXOR()
     {
-        VectorRegister& vd = get_vd();
-        VectorRegister& vs = get_vs();
-        VectorRegister& vt = get_vt();
-        const Elements& e = elements[vuinstr.element];
-
-        for (int i = 0; i < 8; i++)
-        {
-            accumulator_[i].SetLow((vs[i] ^ vt[e[i]]) ^ 0xFFFF);
-        }
-
-        for (int i = 0; i < 8; i++)
-        {
-            vd[i] = accumulator_[i].GetLow();
-        }
+        Vector vs = load(get_vs().data());
+        Vector vt = shuffle(load(get_vt().data()), vuinstr.element);
+        Vector result = not_(xor_(vs, vt));
+        store(accumulator_.low.data(), result);
+        store(get_vd().data(), result);
     }
 
     void RSP::VSAR()
@@ -1116,34 +1336,22 @@ namespace hydra::N64
         {
             case 0x8:
             {
-                for (int i = 0; i < 8; i++)
-                {
-                    vd[i] = accumulator_[i].GetHigh();
-                }
+                vd = accumulator_.high;
                 break;
             }
             case 0x9:
             {
-                for (int i = 0; i < 8; i++)
-                {
-                    vd[i] = accumulator_[i].GetMiddle();
-                }
+                vd = accumulator_.middle;
                 break;
             }
             case 0xA:
             {
-                for (int i = 0; i < 8; i++)
-                {
-                    vd[i] = accumulator_[i].GetLow();
-                }
+                vd = accumulator_.low;
                 break;
             }
             default:
             {
-                for (int i = 0; i < 8; i++)
-                {
-                    vd[i] = 0;
-                }
+                vd.fill(0);
                 break;
             }
         }
@@ -1151,440 +1359,249 @@ namespace hydra::N64
 
     void RSP::VMULF()
     {
-        VectorRegister& vd = get_vd();
-        VectorRegister& vs = get_vs();
-        VectorRegister& vt = get_vt();
-        const Elements& e = elements[vuinstr.element];
+        Vector vs = load(get_vs().data());
+        Vector vt = shuffle(load(get_vt().data()), vuinstr.element);
+        Vector product_low = mullo(vs, vt);
+        Vector product_high = mulhi_signed(vs, vt);
 
-        for (int i = 0; i < 8; i++)
-        {
-            int64_t product = static_cast<int16_t>(vs[i]) * static_cast<int16_t>(vt[e[i]]);
-            accumulator_[i].Set((product << 1) + 0x8000);
-        }
+        // (product << 1) + 0x8000
+        Vector low = sll<1>(product_low);
+        Vector middle = or_(sll<1>(product_high), srl<15>(product_low));
+        Vector round_carry = srl<15>(low);
+        low = xor_(low, broadcast(0x8000));
+        middle = add(middle, round_carry);
+        Vector high = add(sign(product_high), and_(eq(middle, zero()), round_carry));
 
-        for (int i = 0; i < 8; i++)
-        {
-            vd[i] = clamp_signed(accumulator_[i].GetSigned() >> 16);
-        }
+        AccumulatorPlanes accumulator = {high, middle, low};
+        store_accumulator(accumulator_, accumulator);
+        store(get_vd().data(), clamp_signed(accumulator.high, accumulator.middle));
     }
 
     void RSP::VMULU()
     {
-        VectorRegister& vd = get_vd();
-        VectorRegister& vs = get_vs();
-        VectorRegister& vt = get_vt();
-        const Elements& e = elements[vuinstr.element];
+        Vector vs = load(get_vs().data());
+        Vector vt = shuffle(load(get_vt().data()), vuinstr.element);
+        Vector product_low = mullo(vs, vt);
+        Vector product_high = mulhi_signed(vs, vt);
 
-        for (int i = 0; i < 8; i++)
-        {
-            int64_t product = static_cast<int16_t>(vs[i]) * static_cast<int16_t>(vt[e[i]]);
-            accumulator_[i].Set((product << 1) + 0x8000);
-        }
+        Vector low = sll<1>(product_low);
+        Vector middle = or_(sll<1>(product_high), srl<15>(product_low));
+        Vector round_carry = srl<15>(low);
+        low = xor_(low, broadcast(0x8000));
+        middle = add(middle, round_carry);
+        Vector high = add(sign(product_high), and_(eq(middle, zero()), round_carry));
 
-        for (int i = 0; i < 8; i++)
-        {
-            vd[i] = clamp_unsigned(accumulator_[i].GetSigned() >> 16);
-        }
+        AccumulatorPlanes accumulator = {high, middle, low};
+        store_accumulator(accumulator_, accumulator);
+        store(get_vd().data(), clamp_accumulator_unsigned(accumulator));
     }
 
     void RSP::VMUDL()
     {
-        VectorRegister& vd = get_vd();
-        VectorRegister& vs = get_vs();
-        VectorRegister vt = get_vt();
-        const Elements& e = elements[vuinstr.element];
-
-        for (int i = 0; i < 8; i++)
-        {
-            uint64_t product = static_cast<uint64_t>(vs[i]) * vt[e[i]];
-            accumulator_[i].Set(product >> 16);
-        }
-
-        for (int i = 0; i < 8; i++)
-        {
-            if (is_sign_extension(accumulator_[i].GetHigh(), accumulator_[i].GetMiddle()))
-            {
-                vd[i] = accumulator_[i].GetLow();
-            }
-            else if (accumulator_[i].GetHighSigned() < 0)
-            {
-                vd[i] = 0;
-            }
-            else
-            {
-                vd[i] = 0xFFFF;
-            }
-        }
+        Vector vs = load(get_vs().data());
+        Vector vt = shuffle(load(get_vt().data()), vuinstr.element);
+        Vector low = mulhi_unsigned(vs, vt);
+        store_accumulator(accumulator_, {zero(), zero(), low});
+        store(get_vd().data(), low);
     }
 
     void RSP::VMUDM()
     {
-        VectorRegister& vd = get_vd();
-        VectorRegister& vs = get_vs();
-        VectorRegister& vt = get_vt();
-        const Elements& e = elements[vuinstr.element];
-
-        for (int i = 0; i < 8; i++)
-        {
-            int64_t product = vt[e[i]] * static_cast<int16_t>(vs[i]);
-            accumulator_[i].Set(product);
-        }
-
-        for (int i = 0; i < 8; i++)
-        {
-            vd[i] = clamp_signed(accumulator_[i].GetSigned() >> 16);
-        }
+        Vector vs = load(get_vs().data());
+        Vector vt = shuffle(load(get_vt().data()), vuinstr.element);
+        AccumulatorPlanes accumulator = multiply_signed_unsigned(vs, vt);
+        store_accumulator(accumulator_, accumulator);
+        store(get_vd().data(), accumulator.middle);
     }
 
     void RSP::VMUDN()
     {
-        VectorRegister& vd = get_vd();
-        VectorRegister& vs = get_vs();
-        VectorRegister& vt = get_vt();
-        const Elements& e = elements[vuinstr.element];
-
-        for (int i = 0; i < 8; i++)
-        {
-            int64_t product = vs[i] * static_cast<int16_t>(vt[e[i]]);
-            accumulator_[i].Set(product);
-        }
-
-        for (int i = 0; i < 8; i++)
-        {
-            vd[i] = accumulator_[i].Get();
-        }
+        Vector vs = load(get_vs().data());
+        Vector vt = shuffle(load(get_vt().data()), vuinstr.element);
+        AccumulatorPlanes accumulator = multiply_signed_unsigned(vt, vs);
+        store_accumulator(accumulator_, accumulator);
+        store(get_vd().data(), accumulator.low);
     }
 
     void RSP::VMUDH()
     {
-        VectorRegister& vd = get_vd();
-        VectorRegister& vs = get_vs();
-        VectorRegister& vt = get_vt();
-        const Elements& e = elements[vuinstr.element];
-
-        for (int i = 0; i < 8; i++)
-        {
-            int64_t product = static_cast<int16_t>(vs[i]) * static_cast<int16_t>(vt[e[i]]);
-            accumulator_[i].Set(product << 16);
-        }
-
-        for (int i = 0; i < 8; i++)
-        {
-            vd[i] = clamp_signed(accumulator_[i].GetSigned() >> 16);
-        }
-    }
+        Vector vs = load(get_vs().data());
+        Vector vt = shuffle(load(get_vt().data()), vuinstr.element);
+        AccumulatorPlanes accumulator = {mulhi_signed(vs, vt), mullo(vs, vt), zero()};
+        store_accumulator(accumulator_, accumulator);
+        store(get_vd().data(), clamp_signed(accumulator.high, accumulator.middle));
+    }
 
     void RSP::VMACF()
     {
-        VectorRegister& vd = get_vd();
-        VectorRegister& vs = get_vs();
-        VectorRegister& vt = get_vt();
-        const Elements& e = elements[vuinstr.element];
-
-        for (int i = 0; i < 8; i++)
-        {
-            int64_t product = static_cast<int16_t>(vs[i]) * static_cast<int16_t>(vt[e[i]]);
-            accumulator_[i].Add(product << 1);
-        }
+        Vector vs = load(get_vs().data());
+        Vector vt = shuffle(load(get_vt().data()), vuinstr.element);
+        Vector product_low = mullo(vs, vt);
+        Vector product_high = mulhi_signed(vs, vt);
+        AccumulatorPlanes product = {sign(product_high),
+                                     or_(sll<1>(product_high), srl<15>(product_low)),
+                                     sll<1>(product_low)};
 
-        for (int i = 0; i < 8; i++)
-        {
-            vd[i] = clamp_signed(accumulator_[i].GetSigned() >> 16);
-        }
+        AccumulatorPlanes accumulator = add_accumulator(load_accumulator(accumulator_), product);
+        store_accumulator(accumulator_, accumulator);
+        store(get_vd().data(), clamp_signed(accumulator.high, accumulator.middle));
     }
 
     void RSP::VMACU()
     {
-        VectorRegister& vd = get_vd();
-        VectorRegister& vs = get_vs();
-        VectorRegister& vt = get_vt();
-        const Elements& e = elements[vuinstr.element];
-
-        for (int i = 0; i < 8; i++)
-        {
-            int64_t product = static_cast<int16_t>(vs[i]) * static_cast<int16_t>(vt[e[i]]);
-            accumulator_[i].Add(product << 1);
-        }
+        Vector vs = load(get_vs().data());
+        Vector vt = shuffle(load(get_vt().data()), vuinstr.element);
+        Vector product_low = mullo(vs, vt);
+        Vector product_high = mulhi_signed(vs, vt);
+        AccumulatorPlanes product = {sign(product_high),
+                                     or_(sll<1>(product_high), srl<15>(product_low)),
+                                     sll<1>(product_low)};
 
-        for (int i = 0; i < 8; i++)
-        {
-            vd[i] = clamp_unsigned(accumulator_[i].GetSigned() >> 16);
-        }
+        AccumulatorPlanes accumulator = add_accumulator(load_accumulator(accumulator_), product);
+        store_accumulator(accumulator_, accumulator);
+        store(get_vd().data(), clamp_accumulator_unsigned(accumulator));
     }
 
     void RSP::VMADL()
     {
-        VectorRegister& vd = get_vd();
-        VectorRegister& vs = get_vs();
-        VectorRegister& vt = get_vt();
-        const Elements& e = elements[vuinstr.element];
-
-        for (int i = 0; i < 8; i++)
-        {
-            accumulator_[i].Add(((static_cast<int64_t>(vs[i]) * vt[e[i]]) >> 16) & 0xFFFF);
-        }
+        Vector vs = load(get_vs().data());
+        Vector vt = shuffle(load(get_vt().data()), vuinstr.element);
+        AccumulatorPlanes product = {zero(), zero(), mulhi_unsigned(vs, vt)};
 
-        for (int i = 0; i < 8; i++)
-        {
-            if (is_sign_extension(accumulator_[i].GetHigh(), accumulator_[i].GetMiddle()))
-            {
-                vd[i] = accumulator_[i].GetLow();
-            }
-            else if (accumulator_[i].GetHighSigned() < 0)
-            {
-                vd[i] = 0;
-            }
-            else
-            {
-                vd[i] = 0xFFFF;
-            }
-        }
+        AccumulatorPlanes accumulator = add_accumulator(load_accumulator(accumulator_), product);
+        store_accumulator(accumulator_, accumulator);
+        store(get_vd().data(), clamp_accumulator_low(accumulator));
     }
 
     void RSP::VMADM()
     {
-        VectorRegister& vd = get_vd();
-        VectorRegister& vs = get_vs();
-        VectorRegister& vt = get_vt();
-        const Elements& e = elements[vuinstr.element];
-
-        for (int i = 0; i < 8; i++)
-        {
-            accumulator_[i].Add(static_cast<int32_t>(static_cast<int16_t>(vs[i]) * vt[e[i]]));
-        }
-
-        for (int i = 0; i < 8; i++)
-        {
-            vd[i] = clamp_signed(accumulator_[i].GetSigned() >> 16);
-        }
+        Vector vs = load(get_vs().data());
+        Vector vt = shuffle(load(get_vt().data()), vuinstr.element);
+        AccumulatorPlanes accumulator = add_accumulator(load_accumulator(accumulator_),
+                                                        multiply_signed_unsigned(vs, vt));
+        store_accumulator(accumulator_, accumulator);
+        store(get_vd().data(), clamp_signed(accumulator.high, accumulator.middle));
     }
 
     void RSP::VMADN()
     {
-        VectorRegister& vd = get_vd();
-        VectorRegister& vs = get_vs();
-        VectorRegister& vt = get_vt();
-        const Elements& e = elements[vuinstr.element];
-
-        for (int i = 0; i < 8; i++)
-        {
-            int64_t product = static_cast<int32_t>(vs[i] * static_cast<int16_t>(vt[e[i]]));
-            accumulator_[i].Add(product);
-        }
-
-        for (int i = 0; i < 8; i++)
-        {
-            if (is_sign_extension(accumulator_[i].GetHigh(), accumulator_[i].GetMiddle()))
-            {
-                vd[i] = accumulator_[i].GetLow();
-            }
-            else if (accumulator_[i].GetHighSigned() < 0)
-            {
-                vd[i] = 0;
-            }
-            else
-            {
-                vd[i] = 0xFFFF;
-            }
-        }
+        Vector vs = load(get_vs().data());
+        Vector vt = shuffle(load(get_vt().data()), vuinstr.element);
+        AccumulatorPlanes accumulator = add_accumulator(load_accumulator(accumulator_),
+                                                        multiply_signed_unsigned(vt, vs));
+        store_accumulator(accumulator_, accumulator);
+        store(get_vd().data(), clamp_accumulator_low(accumulator));
     }
 
     void RSP::VMADH()
     {
-        VectorRegister& vd = get_vd();
-        VectorRegister& vs = get_vs();
-        VectorRegister& vt = get_vt();
-        const Elements& e = elements[vuinstr.element];
+        Vector vs = load(get_vs().data());
+        Vector vt = shuffle(load(get_vt().data()), vuinstr.element);
+        AccumulatorPlanes product = {mulhi_signed(vs, vt), mullo(vs, vt), zero()};
 
-        for (int i = 0; i < 8; i++)
-        {
-            accumulator_[i].Add(static_cast<int64_t>(static_cast<int32_t>(
-                                    static_cast<int16_t>(vs[i]) * static_cast<int16_t>(vt[e[i]])))
-                                << 16);
-        }
-        for (int i = 0; i < 8; i++)
-        {
-            vd[i] = clamp_signed(accumulator_[i].GetSigned() >> 16);
-        }
+        AccumulatorPlanes accumulator = add_accumulator(load_accumulator(accumulator_), product);
+        store_accumulator(accumulator_, accumulator);
+        store(get_vd().data(), clamp_signed(accumulator.high, accumulator.middle));
     }
 
     void RSP::VADD()
     {
-        VectorRegister& vd = get_vd();
-        VectorRegister& vs = get_vs();
-        VectorRegister vt = get_vt();
-        const Elements& e = elements[vuinstr.element];
-
-        for (int i = 0; i < 8; i++)
-        {
-            int32_t result =
-                static_cast<int16_t>(vs[i]) + static_cast<int16_t>(vt[e[i]]) + vco_.GetLow(i);
-            accumulator_[i].SetLow(result);
-            vd[i] = clamp_signed(result);
-        }
+        Vector vs = load(get_vs().data());
+        Vector vt = shuffle(load(get_vt().data()), vuinstr.element);
+        Vector carry = from_bits(*vco_);
 
+        store(accumulator_.low.data(), sub(add(vs, vt), carry));
+        // Adding the carry to the smaller operand first can't saturate early
+        store(get_vd().data(), adds(subs(min(vs, vt), carry), max(vs, vt)));
         vco_.Clear();
     }
 
     void RSP::VADDC()
     {
-        VectorRegister& vd = get_vd();
-        VectorRegister& vs = get_vs();
-        VectorRegister vt = get_vt();
-        const Elements& e = elements[vuinstr.element];
+        Vector vs = load(get_vs().data());
+        Vector vt = shuffle(load(get_vt().data()), vuinstr.element);
+        Vector result = add(vs, vt);
 
-        vco_.Clear();
-
-        for (int i = 0; i < 8; i++)
-        {
-            uint32_t result = vs[i] + vt[e[i]];
-            accumulator_[i].SetLow(result);
-            vco_.SetLow(i, (result >> 16) & 1);
-        }
-
-        for (int i = 0; i < 8; i++)
-        {
-            vd[i] = accumulator_[i].GetLow();
-        }
+        *vco_ = to_bits(lt_unsigned(result, vs));
+        store(accumulator_.low.data(), result);
+        store(get_vd().data(), result);
     }
 
     void RSP::VSUB()
     {
-        VectorRegister& vd = get_vd();
-        VectorRegister& vs = get_vs();
-        VectorRegister vt = get_vt();
-        const Elements& e = elements[vuinstr.element];
+        Vector vs = load(get_vs().data());
+        Vector vt = shuffle(load(get_vt().data()), vuinstr.element);
+        Vector carry = from_bits(*vco_);
+        Vector subtrahend = sub(vt, carry);
+        Vector subtrahend_saturated = subs(vt, carry);
 
-        for (int i = 0; i < 8; i++)
-        {
-            int32_t result =
-                (static_cast<int16_t>(vs[i]) - static_cast<int16_t>(vt[e[i]]) - vco_.GetLow(i));
-            accumulator_[i].SetLow(result);
-            vd[i] = clamp_signed(result);
-        }
+        store(accumulator_.low.data(), sub(vs, subtrahend));
+        // When vt + carry saturates the saturated subtraction is one short
+        Vector overflow = gt(subtrahend_saturated, subtrahend);
+        store(get_vd().data(), adds(subs(vs, subtrahend_saturated), overflow));
         vco_.Clear();
     }
 
     void RSP::VSUBC()
     {
-        VectorRegister& vd = get_vd();
-        VectorRegister& vs = get_vs();
-        VectorRegister vt = get_vt();
-        const Elements& e = elements[vuinstr.element];
-
-        vco_.Clear();
+        Vector vs = load(get_vs().data());
+        Vector vt = shuffle(load(get_vt().data()), vuinstr.element);
+        Vector result = sub(vs, vt);
 
-        for (int i = 0; i < 8; i++)
-        {
-            uint32_t result = vs[i] - vt[e[i]];
-            accumulator_[i].SetLow(result);
-            vco_.SetLow(i, (result >> 16) & 1);
-            vco_.SetHigh(i, result);
-        }
-
-        for (int i = 0; i < 8; i++)
-        {
-            vd[i] = accumulator_[i].GetLow();
-        }
+        *vco_ = to_bits(lt_unsigned(vs, vt)) | (to_bits(not_(eq(vs, vt))) << 8);
+        store(accumulator_.low.data(), result);
+        store(get_vd().data(), result);
     }
 
     void RSP::VEQ()
     {
-        VectorRegister& vd = get_vd();
-        VectorRegister& vs = get_vs();
-        VectorRegister vt = get_vt();
-        const Elements& e = elements[vuinstr.element];
-
-        vcc_.Clear();
-
-        for (int i = 0; i < 8; i++)
-        {
-            bool test = !vco_.GetHigh(i) && (vs[i] == vt[e[i]]);
-            accumulator_[i].SetLow(test ? vs[i] : vt[e[i]]);
-            vcc_.SetLow(i, test);
-        }
-
-        for (int i = 0; i < 8; i++)
-        {
-            vd[i] = accumulator_[i].GetLow();
-        }
+        Vector vs = load(get_vs().data());
+        Vector vt = shuffle(load(get_vt().data()), vuinstr.element);
+        Vector test = andnot(from_bits(*vco_ >> 8), eq(vs, vt));
 
+        *vcc_ = to_bits(test);
+        store(accumulator_.low.data(), vt);
+        store(get_vd().data(), vt);
         vco_.Clear();
     }
 
     void RSP::VNE()
     {
-        VectorRegister& vd = get_vd();
-        VectorRegister& vs = get_vs();
-        VectorRegister vt = get_vt();
-        const Elements& e = elements[vuinstr.element];
-
-        vcc_.Clear();
-
-        for (int i = 0; i < 8; i++)
-        {
-            int16_t vsi = static_cast<int16_t>(vs[i]);
-            int16_t vti = static_cast<int16_t>(vt[e[i]]);
-            bool test = (vsi != vti || (*vco_ & (0x100 << i)));
-            accumulator_[i].SetLow(test ? vsi : vti);
-            vcc_.SetLow(i, test);
-        }
-
-        for (int i = 0; i < 8; i++)
-        {
-            vd[i] = accumulator_[i].GetLow();
-        }
+        Vector vs = load(get_vs().data());
+        Vector vt = shuffle(load(get_vt().data()), vuinstr.element);
+        Vector test = or_(not_(eq(vs, vt)), from_bits(*vco_ >> 8));
 
+        *vcc_ = to_bits(test);
+        store(accumulator_.low.data(), vs);
+        store(get_vd().data(), vs);
         vco_.Clear();
     }
 
     void RSP::VGE()
     {
-        VectorRegister& vd = get_vd();
-        VectorRegister& vs = get_vs();
-        VectorRegister vt = get_vt();
-        const Elements& e = elements[vuinstr.element];
-
-        vcc_.Clear();
-
-        for (int i = 0; i < 8; i++)
-        {
-            int16_t vsi = static_cast<int16_t>(vs[i]);
-            int16_t vti = static_cast<int16_t>(vt[e[i]]);
-            bool test = (vsi > vti || (vsi == vti && !(((*vco_ & (*vco_ >> 8)) >> i) & 1)));
-            accumulator_[i].SetLow(test ? vsi : vti);
-            vcc_.SetLow(i, test);
-        }
-
-        for (int i = 0; i < 8; i++)
-        {
-            vd[i] = accumulator_[i].GetLow();
-        }
+        Vector vs = load(get_vs().data());
+        Vector vt = shuffle(load(get_vt().data()), vuinstr.element);
+        Vector carry_and_not_equal = from_bits(*vco_ & (*vco_ >> 8));
+        Vector test = or_(gt(vs, vt), andnot(carry_and_not_equal, eq(vs, vt)));
+        Vector result = select(test, vs, vt);
 
+        *vcc_ = to_bits(test);
+        store(accumulator_.low.data(), result);
+        store(get_vd().data(), result);
         vco_.Clear();
     }
 
     void RSP::VLT()
     {
-        VectorRegister& vd = get_vd();
-        VectorRegister& vs = get_vs();
-        VectorRegister vt = get_vt();
-        const Elements& e = elements[vuinstr.element];
-
-        vcc_.Clear();
-
-        for (int i = 0; i < 8; i++)
-        {
-            bool test = vco_.GetHigh(i) && vco_.GetLow(i) && (vs[i] == vt[e[i]]);
-            vcc_.SetLow(i, test || (static_cast<int16_t>(vs[i]) < static_cast<int16_t>(vt[e[i]])));
-            accumulator_[i].SetLow(vcc_.GetLow(i) ? vs[i] : vt[e[i]]);
-        }
-
-        for (int i = 0; i < 8; i++)
-        {
-            vd[i] = accumulator_[i].GetLow();
-        }
+        Vector vs = load(get_vs().data());
+        Vector vt = shuffle(load(get_vt().data()), vuinstr.element);
+        Vector carry_and_not_equal = from_bits(*vco_ & (*vco_ >> 8));
+        Vector test = or_(lt(vs, vt), and_(carry_and_not_equal, eq(vs, vt)));
+        Vector result = select(test, vs, vt);
 
+        *vcc_ = to_bits(test);
+        store(accumulator_.low.data(), result);
+        store(get_vd().data(), result);
         vco_.Clear();
     }
 
@@ -1650,7 +1667,6 @@ namespace hydra::N64
     {
         VectorRegister& vd = get_vd();
         VectorRegister& vt = get_vt();
-        const Elements& e = elements[vuinstr.element];
 
         int32_t input;
         int se = vuinstr.element & 0b111;
@@ -1670,10 +1686,7 @@ namespace hydra::N64
         div_in_ = 0;
         div_in_ready_ = false;
 
-        for (int i = 0; i < 8; i++)
-        {
-            accumulator_[i].SetLow(vt[e[i]]);
-        }
+        store(accumulator_.low.data(), shuffle(load(vt.data()), vuinstr.element));
 
         vd[de] = result & 0xFFFF;
     }
@@ -1682,7 +1695,6 @@ namespace hydra::N64
     {
         VectorRegister& vd = get_vd();
         VectorRegister& vt = get_vt();
-        const Elements& e = elements[vuinstr.element];
 
         int se = vuinstr.element & 0b111;
         int de = vuinstr.vs & 0b111;
@@ -1691,10 +1703,7 @@ namespace hydra::N64
 
         div_out_ = result >> 16;
 
-        for (int i = 0; i < 8; i++)
-        {
-            accumulator_[i].SetLow(vt[e[i]]);
-        }
+        store(accumulator_.low.data(), shuffle(load(vt.data()), vuinstr.element));
 
         vd[de] = result & 0xFFFF;
     }
@@ -1703,7 +1712,6 @@ namespace hydra::N64
     {
         VectorRegister& vd = get_vd();
         VectorRegister& vt = get_vt();
-        const Elements& e = elements[vuinstr.element];
 
         int se = vuinstr.element & 0b111;
         int de = vuinstr.vs & 0b111;
@@ -1712,10 +1720,7 @@ namespace hydra::N64
 
         div_out_ = result >> 16;
 
-        for (int i = 0; i < 8; i++)
-        {
-            accumulator_[i].SetLow(vt[e[i]]);
-        }
+        store(accumulator_.low.data(), shuffle(load(vt.data()), vuinstr.element));
 
         vd[de] = result & 0xFFFF;
     }
@@ -1724,7 +1729,6 @@ namespace hydra::N64
     {
         VectorRegister& vd = get_vd();
         VectorRegister& vt = get_vt();
-        const Elements& e = elements[vuinstr.element];
 
         int32_t input;
         int se = vuinstr.element & 0b111;
@@ -1744,10 +1748,7 @@ namespace hydra::N64
         div_in_ = 0;
         div_in_ready_ = false;
 
-        for (int i = 0; i < 8; i++)
-        {
-            accumulator_[i].SetLow(vt[e[i]]);
-        }
+        store(accumulator_.low.data(), shuffle(load(vt.data()), vuinstr.element));
 
         vd[de] = result & 0xFFFF;
     }
@@ -1756,15 +1757,11 @@ namespace hydra::N64
     {
         VectorRegister& vd = get_vd();
         VectorRegister& vt = get_vt();
-        const Elements& e = elements[vuinstr.element];
 
         int se = vuinstr.element & 0b111;
         int de = vuinstr.vs & 0b111;
 
-        for (int i = 0; i < 8; i++)
-        {
-            accumulator_[i].SetLow(vt[e[i]]);
-        }
+        store(accumulator_.low.data(), shuffle(load(vt.data()), vuinstr.element));
 
         div_in_ = vt[se];
         vd[de] = div_out_;
@@ -1776,7 +1773,7 @@ namespace hydra::N64
     {
         VectorRegister& vd = get_vd();
         VectorRegister& vt = get_vt();
-        const Elements& e = elements[vuinstr.element];
+        const Elements& e = ELEMENTS[vuinstr.element];
         uint8_t element = vuinstr.element & 0b1111;
         uint8_t se;
 
@@ -1804,234 +1801,128 @@ namespace hydra::N64
         uint16_t vti = vt[e[se]];
         vd[vuinstr.vs & 0b111] = vti;
 
-        for (int i = 0; i < 8; i++)
-        {
-            accumulator_[i].SetLow(vt[e[i]]);
-        }
+        store(accumulator_.low.data(), shuffle(load(vt.data()), vuinstr.element));
     }
 
     void RSP::VMRG()
     {
-        VectorRegister& vd = get_vd();
-        VectorRegister& vs = get_vs();
-        VectorRegister& vt = get_vt();
-        const Elements& e = elements[vuinstr.element];
-
-        for (int i = 0; i < 8; i++)
-        {
-            accumulator_[i].SetLow(vcc_.GetLow(i) ? vs[i] : vt[e[i]]);
-        }
-
-        for (int i = 0; i < 8; i++)
-        {
-            vd[i] = accumulator_[i].GetLow();
-        }
+        Vector vs = load(get_vs().data());
+        Vector vt = shuffle(load(get_vt().data()), vuinstr.element);
+        Vector result = select(from_bits(*vcc_), vs, vt);
 
+        store(accumulator_.low.data(), result);
+        store(get_vd().data(), result);
         vco_.Clear();
     }
 
     void RSP::VCH()
     {
-        VectorRegister& vd = get_vd();
-        VectorRegister& vs = get_vs();
-        VectorRegister& vt = get_vt();
-        const Elements& e = elements[vuinstr.element];
+        Vector vs = load(get_vs().data());
+        Vector vt = shuffle(load(get_vt().data()), vuinstr.element);
+        Vector sign_differs = sign(xor_(vs, vt));
+        Vector vt_negative = sign(vt);
+        Vector sum = add(vs, vt);
+        Vector sum_minus_one = eq(sum, broadcast(0xFFFF));
 
-        for (int i = 0; i < 8; i++)
-        {
-            int16_t vsi = static_cast<int16_t>(vs[i]);
-            int16_t vti = static_cast<int16_t>(vt[e[i]]);
-
-            if ((vsi ^ vti) < 0)
-            {
-                int16_t sum = vsi + vti;
-                accumulator_[i].SetLow(sum <= 0 ? -vti : vsi);
-                vcc_.SetLow(i, sum <= 0);
-                vcc_.SetHigh(i, vti < 0);
-                vco_.SetLow(i, true);
-                vco_.SetHigh(i, sum != 0 && (vs[i] != (vt[e[i]] ^ 0xFFFF)));
-                vce_.Set(i, sum == -1);
-            }
-            else
-            {
-                int16_t dif = vsi - vti;
-                accumulator_[i].SetLow(dif >= 0 ? vti : vsi);
-                vcc_.SetLow(i, vti < 0);
-                vcc_.SetHigh(i, dif >= 0);
-                vco_.SetLow(i, false);
-                vco_.SetHigh(i, dif != 0 && (vs[i] != (vt[e[i]] ^ 0xFFFF)));
-                vce_.Set(i, false);
-            }
-        }
+        // Opposite signs compare vs against -vt, same signs against vt
+        Vector le = select(sign_differs, not_(gt(sum, zero())), vt_negative);
+        Vector ge = select(sign_differs, vt_negative, not_(sign(sub(vs, vt))));
+        Vector not_equal = select(sign_differs, not_(or_(eq(sum, zero()), sum_minus_one)),
+                                  not_(eq(vs, vt)));
+        Vector result = select(sign_differs, select(le, neg(vt), vs), select(ge, vt, vs));
 
-        for (int i = 0; i < 8; i++)
-        {
-            vd[i] = accumulator_[i].GetLow();
-        }
+        *vcc_ = to_bits(le) | (to_bits(ge) << 8);
+        *vco_ = to_bits(sign_differs) | (to_bits(not_equal) << 8);
+        *vce_ = to_bits(and_(sign_differs, sum_minus_one));
+        store(accumulator_.low.data(), result);
+        store(get_vd().data(), result);
     }
 
     void RSP::VCR()
     {
-        VectorRegister& vd = get_vd();
-        VectorRegister& vs = get_vs();
-        VectorRegister& vt = get_vt();
-        const Elements& e = elements[vuinstr.element];
-
-        for (int i = 0; i < 8; i++)
-        {
-            bool sign = (0x8000 & (vs[i] ^ vt[e[i]])) != 0;
-            uint16_t vti = sign ? ~vt[e[i]] : vt[e[i]];
-
-            bool gte =
-                static_cast<int16_t>(vt[e[i]]) <= static_cast<int16_t>(sign ? 0xFFFF : vs[i]);
-            bool lte = (((sign ? vs[i] : 0) + vt[e[i]]) & 0x8000) != 0;
+        Vector vs = load(get_vs().data());
+        Vector vt = shuffle(load(get_vt().data()), vuinstr.element);
+        Vector sign_differs = sign(xor_(vs, vt));
 
-            bool check = sign ? lte : gte;
-            uint16_t result = check ? vti : vs[i];
-            accumulator_[i].SetLow(result);
-
-            vcc_.SetHigh(i, gte);
-            vcc_.SetLow(i, lte);
-        }
-
-        for (int i = 0; i < 8; i++)
-        {
-            vd[i] = accumulator_[i].GetLow();
-        }
+        Vector ge = not_(gt(vt, or_(vs, sign_differs)));
+        Vector le = sign(add(and_(vs, sign_differs), vt));
+        Vector check = select(sign_differs, le, ge);
+        Vector result = select(check, xor_(vt, sign_differs), vs);
 
+        *vcc_ = to_bits(le) | (to_bits(ge) << 8);
+        store(accumulator_.low.data(), result);
+        store(get_vd().data(), result);
         vco_.Clear();
         vce_.Clear();
     }
 
     void RSP::VCL()
     {
-        VectorRegister& vd = get_vd();
-        VectorRegister& vs = get_vs();
-        VectorRegister& vt = get_vt();
-        const Elements& e = elements[vuinstr.element];
-
-        for (int i = 0; i < 8; i++)
-        {
-            if (vco_.GetLow(i))
-            {
-                if (vco_.GetHigh(i))
-                {
-                    accumulator_[i].SetLow(vcc_.GetLow(i) ? -vt[e[i]] : vs[i]);
-                }
-                else
-                {
-                    uint16_t result = 0;
-                    bool overflow = hydra::add_overflow(vs[i], vt[e[i]], result);
-                    if (vce_.Get(i))
-                    {
-                        vcc_.SetLow(i, !result || !overflow);
-                        accumulator_[i].SetLow(vcc_.GetLow(i) ? -vt[e[i]] : vs[i]);
-                    }
-                    else
-                    {
-                        vcc_.SetLow(i, !result && !overflow);
-                        accumulator_[i].SetLow(vcc_.GetLow(i) ? -vt[e[i]] : vs[i]);
-                    }
-                }
-            }
-            else
-            {
-                if (vco_.GetHigh(i))
-                {
-                    accumulator_[i].SetLow(vcc_.GetHigh(i) ? vt[e[i]] : vs[i]);
-                }
-                else
-                {
-                    vcc_.SetHigh(i, vs[i] >= vt[e[i]]);
-                    accumulator_[i].SetLow(vcc_.GetHigh(i) ? vt[e[i]] : vs[i]);
-                }
-            }
-        }
-
-        for (int i = 0; i < 8; i++)
-        {
-            vd[i] = accumulator_[i].GetLow();
-        }
-
+        Vector vs = load(get_vs().data());
+        Vector vt = shuffle(load(get_vt().data()), vuinstr.element);
+        Vector vco_low = from_bits(*vco_);
+        Vector vco_high = from_bits(*vco_ >> 8);
+        Vector vcc_low = from_bits(*vcc_);
+        Vector vcc_high = from_bits(*vcc_ >> 8);
+        Vector vce = from_bits(*vce_);
+
+        Vector sum = add(vs, vt);
+        Vector carry = lt_unsigned(sum, vs);
+        Vector sum_zero = eq(sum, zero());
+        Vector le = select(vce, or_(sum_zero, not_(carry)), andnot(carry, sum_zero));
+        Vector ge = not_(lt_unsigned(vs, vt));
+
+        // The compare flags are only updated for lanes where vco_high is clear
+        vcc_low = select(andnot(vco_high, vco_low), le, vcc_low);
+        vcc_high = select(or_(vco_low, vco_high), vcc_high, ge);
+        Vector result =
+            select(vco_low, select(vcc_low, neg(vt), vs), select(vcc_high, vt, vs));
+
+        *vcc_ = to_bits(vcc_low) | (to_bits(vcc_high) << 8);
+        store(accumulator_.low.data(), result);
+        store(get_vd().data(), result);
         vco_.Clear();
         vce_.Clear();
     }
 
     void RSP::VABS()
     {
-        VectorRegister& vd = get_vd();
-        VectorRegister& vs = get_vs();
-        VectorRegister& vt = get_vt();
-        const Elements& e = elements[vuinstr.element];
-        std::array<bool, 8> edge_case{};
-
-        for (int i = 0; i < 8; i++)
-        {
-            uint16_t data = 0;
-            if (static_cast<int16_t>(vs[i]) < 0)
-            {
-                if (vt[e[i]] == 0x8000)
-                {
-                    edge_case[i] = true;
-                }
-                data = -vt[e[i]];
-            }
-            else if (static_cast<int16_t>(vs[i]) > 0)
-            {
-                data = vt[e[i]];
-            }
-            accumulator_[i].SetLow(data);
-        }
+        Vector vs = load(get_vs().data());
+        Vector vt = shuffle(load(get_vt().data()), vuinstr.element);
+        Vector negative = sign(vs);
+        Vector result = select(negative, neg(vt), and_(gt(vs, zero()), vt));
 
-        for (int i = 0; i < 8; i++)
-        {
-            vd[i] = accumulator_[i].GetLow();
-            if (edge_case[i]) [[unlikely]]
-            {
-                vd[i] = 0x7FFF;
-            }
-        }
+        store(accumulator_.low.data(), result);
+        // Only the destination saturates when negating 0x8000
+        Vector overflow = and_(negative, eq(vt, broadcast(0x8000)));
+        store(get_vd().data(), select(overflow, broadcast(0x7FFF), result));
     }
 
     void RSP::VZERO()
     {
-        VectorRegister& vd = get_vd();
-        VectorRegister& vs = get_vs();
-        VectorRegister& vt = get_vt();
-        const Elements& e = elements[vuinstr.element];
-
-        for (int i = 0; i < 8; i++)
-        {
-            accumulator_[i].SetLow(vt[e[i]] + vs[i]);
-        }
+        Vector vs = load(get_vs().data());
+        Vector vt = shuffle(load(get_vt().data()), vuinstr.element);
 
-        for (int i = 0; i < 8; i++)
-        {
-            vd[i] = 0;
-        }
+        store(accumulator_.low.data(), add(vs, vt));
+        store(get_vd().data(), zero());
     }
 
     void RSP::VMULQ()
     {
-        VectorRegister& vd = get_vd();
-        VectorRegister& vs = get_vs();
-        VectorRegister vt = get_vt();
-        const Elements& e = elements[vuinstr.element];
-
-        for (int i = 0; i < 8; i++)
-        {
-            int32_t product = static_cast<int16_t>(vs[i]) * static_cast<int16_t>(vt[e[i]]);
-            if (product < 0)
-            {
-                product += 31;
-            }
+        Vector vs = load(get_vs().data());
+        Vector vt = shuffle(load(get_vt().data()), vuinstr.element);
+        Vector product_low = mullo(vs, vt);
+        Vector product_high = mulhi_signed(vs, vt);
 
-            accumulator_[i].SetHigh(product >> 16);
-            accumulator_[i].SetMiddle(product);
-            accumulator_[i].SetLow(0);
+        // Negative products get 31 added to them
+        Vector rounded_low = add(product_low, and_(sign(product_high), broadcast(31)));
+        Vector rounded_high = sub(product_high, lt_unsigned(rounded_low, product_low));
+        store_accumulator(accumulator_, {rounded_high, rounded_low, zero()});
 
-            vd[i] = clamp_signed(product >> 1) & ~0b1111;
-        }
+        Vector shifted_high = sra<1>(rounded_high);
+        Vector shifted_low = or_(srl<1>(rounded_low), sll<15>(rounded_high));
+        store(get_vd().data(),
+              and_(clamp_signed(shifted_high, shifted_low), broadcast(~0b1111)));
     }
 
     void RSP::VMACQ()
@@ -2040,7 +1931,8 @@ namespace hydra::N64
 
         for (int i = 0; i < 8; i++)
         {
-            int32_t product = (accumulator_[i].GetHigh() << 16) | accumulator_[i].GetMiddle();
+            int32_t product = static_cast<int32_t>(
+                (static_cast<uint32_t>(accumulator_.high[i]) << 16) | accumulator_.middle[i]);
             if (product < 0 && !(product & 1 << 5))
             {
                 product += 32;
@@ -2049,10 +1941,10 @@ namespace hydra::N64
             {
                 product -= 32;
             }
-            accumulator_[i].SetHigh(product >> 16);
-            accumulator_[i].SetMiddle(product);
+            accumulator_.high[i] = product >> 16;
+            accumulator_.middle[i] = product;
 
-            vd[i] = clamp_signed(product >> 1) & ~0b1111;
+            vd[i] = std::clamp<int32_t>(product >> 1, INT16_MIN, INT16_MAX) & ~0b1111;
         }
     }
 
@@ -2143,7 +2035,7 @@ namespace hydra::N64
         if (status_.intr_break)
         {
             Logger::Debug("Raising SP interrupt");
-            interrupt_callback_(true);
+            post_callback([this] { interrupt_callback_(true); });
         }
     }
 
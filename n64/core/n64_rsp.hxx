@@ -1,7 +1,15 @@
 #pragma once
 
+#include <atomic>
+#include <condition_variable>
 #include <functional>
+#include <memory>
+#include <mutex>
 #include <n64/core/n64_types.hxx>
+#include <state.hxx>
+#include <thread>
+#include <unordered_map>
+#include <vector>
 
 namespace hydra::N64
 {
@@ -32,66 +40,13 @@ namespace hydra::N64
     class RDP;
     using VectorRegister = std::array<uint16_t, 8>;
 
-    struct AccumulatorLane
+    // The 48-bit accumulator lanes split into three planes of 16-bit lanes so each one can be
+    // worked on with a single vector operation
+    struct Accumulator
     {
-        void Set(uint64_t new_value)
-        {
-            value_ = new_value & 0xFFFF'FFFF'FFFF;
-        }
-
-        void SetHigh(uint16_t new_value)
-        {
-            value_ = (static_cast<uint64_t>(new_value) << 32) | (value_ & 0xFFFF'FFFF);
-        }
-
-        void SetMiddle(uint16_t new_value)
-        {
-            value_ = (static_cast<uint64_t>(new_value) << 16) | (value_ & 0xFFFF'0000'FFFF);
-        }
-
-        void SetLow(uint16_t new_value)
-        {
-            value_ = (value_ & 0xFFFF'FFFF'0000) | new_value;
-        }
-
-        uint64_t Get() const
-        {
-            return value_;
-        }
-
-        int64_t GetSigned() const
-        {
-            return static_cast<int64_t>(value_ << 16) >> 16;
-        }
-
-        uint16_t GetHigh() const
-        {
-            return value_ >> 32;
-        }
-
-        uint16_t GetMiddle() const
-        {
-            return (value_ >> 16) & 0xFFFF;
-        }
-
-        uint16_t GetLow() const
-        {
-            return value_ & 0xFFFF;
-        }
-
-        int16_t GetHighSigned() const
-        {
-            return value_ >> 32;
-        }
-
-        void Add(int64_t value)
-        {
-            value_ = static_cast<int64_t>(value_) + value;
-            value_ &= 0xFFFF'FFFF'FFFF;
-        }
-
-    private:
-        uint64_t value_ = 0;
+        alignas(16) VectorRegister high{};
+        alignas(16) VectorRegister middle{};
+        alignas(16) VectorRegister low{};
     };
 
     struct VUControl16
@@ -230,11 +185,31 @@ namespace hydra::N64
     {
     public:
         RSP();
+        ~RSP();
         void Tick();
+        uint64_t Run(uint64_t instructions);
+        void RunAsync(uint64_t instructions);
+        void Sync();
+        void SetThreaded(bool threaded);
+        bool IsThreaded();
         void Reset();
+        void SaveState(StateWriter& writer) const;
+        void LoadState(StateReader& reader);
         bool IsHalted();
         void InstallBuses(uint8_t* rdram_ptr, RDP* rdp_ptr);
         void SetInterruptCallback(std::function<void(bool)> callback);
+        void SetRDRAMWriteCallback(std::function<void(uint32_t, uint32_t)> callback);
+
+        // Nanoseconds spent in Run and the instructions it executed, on either thread
+        uint64_t GetBusyTime() const
+        {
+            return busy_time_.load(std::memory_order_relaxed);
+        }
+
+        uint64_t GetExecuted() const
+        {
+            return executed_.load(std::memory_order_relaxed);
+        }
 
     private:
         using func_ptr = void (*)(RSP*);
@@ -351,8 +326,27 @@ namespace hydra::N64
             &lut_wrapper<&RSP::ERROR2>, &lut_wrapper<&RSP::ERROR2>,
         };
 
-        void execute_instruction();
-        uint32_t fetch_instruction();
+        // Microcode is decoded once per unique IMEM image, keyed by its crc32 and kept for the
+        // rest of the session so switching between the graphics and audio tasks is free
+        struct DecodedInstruction
+        {
+            func_ptr handler;
+            Instruction instruction;
+        };
+
+        struct DecodedIMEM
+        {
+            std::array<uint8_t, 0x1000> imem;
+            std::array<DecodedInstruction, 0x400> code;
+        };
+
+        constexpr static size_t MAX_CACHED_IMEMS = 64;
+
+        static DecodedInstruction decode_instruction(uint32_t instruction);
+        void update_decoded_imem();
+        void invalidate_imem();
+        void worker_loop();
+        void post_callback(std::function<void()> callback);
         uint8_t load_byte(uint16_t address);
         uint16_t load_halfword(uint16_t address);
         uint32_t load_word(uint16_t address);
@@ -381,12 +375,12 @@ namespace hydra::N64
 
         std::array<uint8_t, 0x2000> mem_{};
         std::array<MemDataUnionW, 32> gpr_regs_;
-        std::array<VectorRegister, 32> vu_regs_;
+        alignas(16) std::array<VectorRegister, 32> vu_regs_;
         VUControl16 vco_, vcc_;
         VUControl8 vce_;
         int16_t div_in_, div_out_;
         bool div_in_ready_ = false;
-        std::array<AccumulatorLane, 8> accumulator_;
+        Accumulator accumulator_;
 
         // TODO: some are probably not needed
         Instruction instruction_;
@@ -402,6 +396,23 @@ namespace hydra::N64
         uint8_t* rdram_ptr_ = nullptr;
         RDP* rdp_ptr_ = nullptr;
         std::function<void(bool)> interrupt_callback_;
+        std::function<void(uint32_t, uint32_t)> rdram_write_callback_;
+        std::unordered_map<uint32_t, std::unique_ptr<DecodedIMEM>> imem_cache_;
+        DecodedIMEM* decoded_imem_ = nullptr;
+        bool imem_dirty_ = true;
+
+        // Threaded mode: batches run on worker_ while the CPU keeps going, and anything that would
+        // touch CPU state from the worker is queued in deferred_callbacks_ until the next Sync
+        std::thread worker_;
+        std::mutex worker_mutex_;
+        std::condition_variable worker_cv_;
+        uint64_t worker_budget_ = 0;
+        bool worker_busy_ = false;
+        bool worker_exit_ = false;
+        bool batch_in_flight_ = false;
+        std::vector<std::function<void()>> deferred_callbacks_;
+        std::atomic<uint64_t> busy_time_ = 0;
+        std::atomic<uint64_t> executed_ = 0;
 
         friend class hydra::N64::CPU;
         friend class hydra::N64::CPUBus;
@@ -0,0 +1,614 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <compatibility.hxx>
+#include <cstdint>
+
+#if defined(__SSE4_1__) || defined(_M_X64)
+#define HYDRA_RSP_SSE
+#include <smmintrin.h>
+#elif defined(__aarch64__) || defined(__arm64__)
+#define HYDRA_RSP_NEON
+#include <arm_neon.h>
+#endif
+
+// Thin wrapper over 8x16-bit vectors for the RSP vector unit, one implementation per host ISA.
+// Lane i always holds element i of an RSP vector register. Comparisons return all ones/all zeroes
+// lane masks, signed ones treat the lanes as int16_t.
+namespace hydra::N64::simd
+{
+    using Elements = std::array<uint8_t, 8>;
+
+    // Lane broadcast patterns selected by the element field of VU instructions
+    constexpr std::array<Elements, 16> ELEMENTS = {{{0, 1, 2, 3, 4, 5, 6, 7},
+                                                    {0, 1, 2, 3, 4, 5, 6, 7},
+                                                    {0, 0, 2, 2, 4, 4, 6, 6},
+                                                    {1, 1, 3, 3, 5, 5, 7, 7},
+                                                    {0, 0, 0, 0, 4, 4, 4, 4},
+                                                    {1, 1, 1, 1, 5, 5, 5, 5},
+                                                    {2, 2, 2, 2, 6, 6, 6, 6},
+                                                    {3, 3, 3, 3, 7, 7, 7, 7},
+                                                    {0, 0, 0, 0, 0, 0, 0, 0},
+                                                    {1, 1, 1, 1, 1, 1, 1, 1},
+                                                    {2, 2, 2, 2, 2, 2, 2, 2},
+                                                    {3, 3, 3, 3, 3, 3, 3, 3},
+                                                    {4, 4, 4, 4, 4, 4, 4, 4},
+                                                    {5, 5, 5, 5, 5, 5, 5, 5},
+                                                    {6, 6, 6, 6, 6, 6, 6, 6},
+                                                    {7, 7, 7, 7, 7, 7, 7, 7}}};
+
+    // The same patterns as byte shuffle masks
+    struct alignas(16) ShuffleMask
+    {
+        std::array<uint8_t, 16> bytes;
+    };
+
+    constexpr std::array<ShuffleMask, 16> make_shuffle_masks()
+    {
+        std::array<ShuffleMask, 16> masks{};
+        for (size_t e = 0; e < ELEMENTS.size(); e++)
+        {
+            for (size_t i = 0; i < 8; i++)
+            {
+                masks[e].bytes[i * 2] = ELEMENTS[e][i] * 2;
+                masks[e].bytes[i * 2 + 1] = ELEMENTS[e][i] * 2 + 1;
+            }
+        }
+        return masks;
+    }
+
+    constexpr std::array<ShuffleMask, 16> SHUFFLE_MASKS = make_shuffle_masks();
+
+#if defined(HYDRA_RSP_SSE)
+    using Vector = __m128i;
+
+    hydra_inline Vector load(const uint16_t* data)
+    {
+        return _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+    }
+
+    hydra_inline void store(uint16_t* data, Vector v)
+    {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(data), v);
+    }
+
+    hydra_inline Vector broadcast(uint16_t value)
+    {
+        return _mm_set1_epi16(value);
+    }
+
+    hydra_inline Vector zero()
+    {
+        return _mm_setzero_si128();
+    }
+
+    hydra_inline Vector shuffle(Vector v, int element)
+    {
+        return _mm_shuffle_epi8(
+            v, _mm_load_si128(reinterpret_cast<const __m128i*>(&SHUFFLE_MASKS[element])));
+    }
+
+    hydra_inline Vector add(Vector a, Vector b)
+    {
+        return _mm_add_epi16(a, b);
+    }
+
+    hydra_inline Vector sub(Vector a, Vector b)
+    {
+        return _mm_sub_epi16(a, b);
+    }
+
+    hydra_inline Vector adds(Vector a, Vector b)
+    {
+        return _mm_adds_epi16(a, b);
+    }
+
+    hydra_inline Vector subs(Vector a, Vector b)
+    {
+        return _mm_subs_epi16(a, b);
+    }
+
+    hydra_inline Vector min(Vector a, Vector b)
+    {
+        return _mm_min_epi16(a, b);
+    }
+
+    hydra_inline Vector max(Vector a, Vector b)
+    {
+        return _mm_max_epi16(a, b);
+    }
+
+    hydra_inline Vector and_(Vector a, Vector b)
+    {
+        return _mm_and_si128(a, b);
+    }
+
+    hydra_inline Vector or_(Vector a, Vector b)
+    {
+        return _mm_or_si128(a, b);
+    }
+
+    hydra_inline Vector xor_(Vector a, Vector b)
+    {
+        return _mm_xor_si128(a, b);
+    }
+
+    // ~a & b
+    hydra_inline Vector andnot(Vector a, Vector b)
+    {
+        return _mm_andnot_si128(a, b);
+    }
+
+    hydra_inline Vector not_(Vector a)
+    {
+        return _mm_xor_si128(a, _mm_cmpeq_epi16(a, a));
+    }
+
+    hydra_inline Vector mullo(Vector a, Vector b)
+    {
+        return _mm_mullo_epi16(a, b);
+    }
+
+    hydra_inline Vector mulhi_signed(Vector a, Vector b)
+    {
+        return _mm_mulhi_epi16(a, b);
+    }
+
+    hydra_inline Vector mulhi_unsigned(Vector a, Vector b)
+    {
+        return _mm_mulhi_epu16(a, b);
+    }
+
+    hydra_inline Vector eq(Vector a, Vector b)
+    {
+        return _mm_cmpeq_epi16(a, b);
+    }
+
+    hydra_inline Vector gt(Vector a, Vector b)
+    {
+        return _mm_cmpgt_epi16(a, b);
+    }
+
+    hydra_inline Vector lt(Vector a, Vector b)
+    {
+        return _mm_cmplt_epi16(a, b);
+    }
+
+    hydra_inline Vector lt_unsigned(Vector a, Vector b)
+    {
+        return not_(_mm_cmpeq_epi16(_mm_max_epu16(a, b), a));
+    }
+
+    // mask ? a : b
+    hydra_inline Vector select(Vector mask, Vector a, Vector b)
+    {
+        return _mm_blendv_epi8(b, a, mask);
+    }
+
+    template <int N>
+    hydra_inline Vector sra(Vector v)
+    {
+        return _mm_srai_epi16(v, N);
+    }
+
+    template <int N>
+    hydra_inline Vector srl(Vector v)
+    {
+        return _mm_srli_epi16(v, N);
+    }
+
+    template <int N>
+    hydra_inline Vector sll(Vector v)
+    {
+        return _mm_slli_epi16(v, N);
+    }
+
+    // Clamps the 32-bit values high:low to int16_t
+    hydra_inline Vector clamp_signed(Vector high, Vector low)
+    {
+        return _mm_packs_epi32(_mm_unpacklo_epi16(low, high), _mm_unpackhi_epi16(low, high));
+    }
+
+    hydra_inline uint8_t to_bits(Vector mask)
+    {
+        return _mm_movemask_epi8(_mm_packs_epi16(mask, _mm_setzero_si128()));
+    }
+
+    hydra_inline Vector from_bits(uint8_t bits)
+    {
+        const __m128i lanes = _mm_setr_epi16(1, 2, 4, 8, 16, 32, 64, 128);
+        return _mm_cmpeq_epi16(_mm_and_si128(_mm_set1_epi16(bits), lanes), lanes);
+    }
+#elif defined(HYDRA_RSP_NEON)
+    using Vector = uint16x8_t;
+
+    hydra_inline int16x8_t as_signed(Vector v)
+    {
+        return vreinterpretq_s16_u16(v);
+    }
+
+    hydra_inline Vector as_unsigned(int16x8_t v)
+    {
+        return vreinterpretq_u16_s16(v);
+    }
+
+    hydra_inline Vector load(const uint16_t* data)
+    {
+        return vld1q_u16(data);
+    }
+
+    hydra_inline void store(uint16_t* data, Vector v)
+    {
+        vst1q_u16(data, v);
+    }
+
+    hydra_inline Vector broadcast(uint16_t value)
+    {
+        return vdupq_n_u16(value);
+    }
+
+    hydra_inline Vector zero()
+    {
+        return vdupq_n_u16(0);
+    }
+
+    hydra_inline Vector shuffle(Vector v, int element)
+    {
+        return vreinterpretq_u16_u8(
+            vqtbl1q_u8(vreinterpretq_u8_u16(v), vld1q_u8(SHUFFLE_MASKS[element].bytes.data())));
+    }
+
+    hydra_inline Vector add(Vector a, Vector b)
+    {
+        return vaddq_u16(a, b);
+    }
+
+    hydra_inline Vector sub(Vector a, Vector b)
+    {
+        return vsubq_u16(a, b);
+    }
+
+    hydra_inline Vector adds(Vector a, Vector b)
+    {
+        return as_unsigned(vqaddq_s16(as_signed(a), as_signed(b)));
+    }
+
+    hydra_inline Vector subs(Vector a, Vector b)
+    {
+        return as_unsigned(vqsubq_s16(as_signed(a), as_signed(b)));
+    }
+
+    hydra_inline Vector min(Vector a, Vector b)
+    {
+        return as_unsigned(vminq_s16(as_signed(a), as_signed(b)));
+    }
+
+    hydra_inline Vector max(Vector a, Vector b)
+    {
+        return as_unsigned(vmaxq_s16(as_signed(a), as_signed(b)));
+    }
+
+    hydra_inline Vector and_(Vector a, Vector b)
+    {
+        return vandq_u16(a, b);
+    }
+
+    hydra_inline Vector or_(Vector a, Vector b)
+    {
+        return vorrq_u16(a, b);
+    }
+
+    hydra_inline Vector xor_(Vector a, Vector b)
+    {
+        return veorq_u16(a, b);
+    }
+
+    // ~a & b
+    hydra_inline Vector andnot(Vector a, Vector b)
+    {
+        return vbicq_u16(b, a);
+    }
+
+    hydra_inline Vector not_(Vector a)
+    {
+        return vmvnq_u16(a);
+    }
+
+    hydra_inline Vector mullo(Vector a, Vector b)
+    {
+        return vmulq_u16(a, b);
+    }
+
+    hydra_inline Vector mulhi_signed(Vector a, Vector b)
+    {
+        int32x4_t low = vmull_s16(vget_low_s16(as_signed(a)), vget_low_s16(as_signed(b)));
+        int32x4_t high = vmull_high_s16(as_signed(a), as_signed(b));
+        return vuzp2q_u16(vreinterpretq_u16_s32(low), vreinterpretq_u16_s32(high));
+    }
+
+    hydra_inline Vector mulhi_unsigned(Vector a, Vector b)
+    {
+        uint32x4_t low = vmull_u16(vget_low_u16(a), vget_low_u16(b));
+        uint32x4_t high = vmull_high_u16(a, b);
+        return vuzp2q_u16(vreinterpretq_u16_u32(low), vreinterpretq_u16_u32(high));
+    }
+
+    hydra_inline Vector eq(Vector a, Vector b)
+    {
+        return vceqq_u16(a, b);
+    }
+
+    hydra_inline Vector gt(Vector a, Vector b)
+    {
+        return vcgtq_s16(as_signed(a), as_signed(b));
+    }
+
+    hydra_inline Vector lt(Vector a, Vector b)
+    {
+        return vcltq_s16(as_signed(a), as_signed(b));
+    }
+
+    hydra_inline Vector lt_unsigned(Vector a, Vector b)
+    {
+        return vcltq_u16(a, b);
+    }
+
+    // mask ? a : b
+    hydra_inline Vector select(Vector mask, Vector a, Vector b)
+    {
+        return vbslq_u16(mask, a, b);
+    }
+
+    template <int N>
+    hydra_inline Vector sra(Vector v)
+    {
+        return as_unsigned(vshrq_n_s16(as_signed(v), N));
+    }
+
+    template <int N>
+    hydra_inline Vector srl(Vector v)
+    {
+        return vshrq_n_u16(v, N);
+    }
+
+    template <int N>
+    hydra_inline Vector sll(Vector v)
+    {
+        return vshlq_n_u16(v, N);
+    }
+
+    // Clamps the 32-bit values high:low to int16_t
+    hydra_inline Vector clamp_signed(Vector high, Vector low)
+    {
+        int32x4_t low_words = vreinterpretq_s32_u16(vzip1q_u16(low, high));
+        int32x4_t high_words = vreinterpretq_s32_u16(vzip2q_u16(low, high));
+        return as_unsigned(vcombine_s16(vqmovn_s32(low_words), vqmovn_s32(high_words)));
+    }
+
+    hydra_inline uint8_t to_bits(Vector mask)
+    {
+        const uint16x8_t lanes = {1, 2, 4, 8, 16, 32, 64, 128};
+        return vaddvq_u16(vandq_u16(mask, lanes));
+    }
+
+    hydra_inline Vector from_bits(uint8_t bits)
+    {
+        const uint16x8_t lanes = {1, 2, 4, 8, 16, 32, 64, 128};
+        return vtstq_u16(vdupq_n_u16(bits), lanes);
+    }
+#else
+    struct Vector
+    {
+        std::array<uint16_t, 8> lanes;
+    };
+
+    template <class Func>
+    hydra_inline Vector map(Vector a, Vector b, Func func)
+    {
+        Vector result;
+        for (int i = 0; i < 8; i++)
+        {
+            result.lanes[i] = func(a.lanes[i], b.lanes[i]);
+        }
+        return result;
+    }
+
+    hydra_inline uint16_t mask_of(bool condition)
+    {
+        return condition ? 0xFFFF : 0;
+    }
+
+    hydra_inline Vector load(const uint16_t* data)
+    {
+        Vector result;
+        std::copy(data, data + 8, result.lanes.begin());
+        return result;
+    }
+
+    hydra_inline void store(uint16_t* data, Vector v)
+    {
+        std::copy(v.lanes.begin(), v.lanes.end(), data);
+    }
+
+    hydra_inline Vector broadcast(uint16_t value)
+    {
+        Vector result;
+        result.lanes.fill(value);
+        return result;
+    }
+
+    hydra_inline Vector zero()
+    {
+        return broadcast(0);
+    }
+
+    hydra_inline Vector shuffle(Vector v, int element)
+    {
+        Vector result;
+        for (int i = 0; i < 8; i++)
+        {
+            result.lanes[i] = v.lanes[ELEMENTS[element][i]];
+        }
+        return result;
+    }
+
+    hydra_inline int16_t saturate(int32_t value)
+    {
+        return std::clamp<int32_t>(value, INT16_MIN, INT16_MAX);
+    }
+
+    hydra_inline Vector add(Vector a, Vector b)
+    {
+        return map(a, b, [](uint16_t x, uint16_t y) { return x + y; });
+    }
+
+    hydra_inline Vector sub(Vector a, Vector b)
+    {
+        return map(a, b, [](uint16_t x, uint16_t y) { return x - y; });
+    }
+
+    hydra_inline Vector adds(Vector a, Vector b)
+    {
+        return map(a, b, [](int16_t x, int16_t y) { return saturate(x + y); });
+    }
+
+    hydra_inline Vector subs(Vector a, Vector b)
+    {
+        return map(a, b, [](int16_t x, int16_t y) { return saturate(x - y); });
+    }
+
+    hydra_inline Vector min(Vector a, Vector b)
+    {
+        return map(a, b, [](int16_t x, int16_t y) { return std::min(x, y); });
+    }
+
+    hydra_inline Vector max(Vector a, Vector b)
+    {
+        return map(a, b, [](int16_t x, int16_t y) { return std::max(x, y); });
+    }
+
+    hydra_inline Vector and_(Vector a, Vector b)
+    {
+        return map(a, b, [](uint16_t x, uint16_t y) { return x & y; });
+    }
+
+    hydra_inline Vector or_(Vector a, Vector b)
+    {
+        return map(a, b, [](uint16_t x, uint16_t y) { return x | y; });
+    }
+
+    hydra_inline Vector xor_(Vector a, Vector b)
+    {
+        return map(a, b, [](uint16_t x, uint16_t y) { return x ^ y; });
+    }
+
+    // ~a & b
+    hydra_inline Vector andnot(Vector a, Vector b)
+    {
+        return map(a, b, [](uint16_t x, uint16_t y) { return ~x & y; });
+    }
+
+    hydra_inline Vector not_(Vector a)
+    {
+        return xor_(a, broadcast(0xFFFF));
+    }
+
+    hydra_inline Vector mullo(Vector a, Vector b)
+    {
+        return map(a, b, [](uint16_t x, uint16_t y) { return uint32_t(x) * y; });
+    }
+
+    hydra_inline Vector mulhi_signed(Vector a, Vector b)
+    {
+        return map(a, b, [](int16_t x, int16_t y) { return (x * y) >> 16; });
+    }
+
+    hydra_inline Vector mulhi_unsigned(Vector a, Vector b)
+    {
+        return map(a, b, [](uint16_t x, uint16_t y) { return (uint32_t(x) * y) >> 16; });
+    }
+
+    hydra_inline Vector eq(Vector a, Vector b)
+    {
+        return map(a, b, [](uint16_t x, uint16_t y) { return mask_of(x == y); });
+    }
+
+    hydra_inline Vector gt(Vector a, Vector b)
+    {
+        return map(a, b, [](int16_t x, int16_t y) { return mask_of(x > y); });
+    }
+
+    hydra_inline Vector lt(Vector a, Vector b)
+    {
+        return map(a, b, [](int16_t x, int16_t y) { return mask_of(x < y); });
+    }
+
+    hydra_inline Vector lt_unsigned(Vector a, Vector b)
+    {
+        return map(a, b, [](uint16_t x, uint16_t y) { return mask_of(x < y); });
+    }
+
+    // mask ? a : b
+    hydra_inline Vector select(Vector mask, Vector a, Vector b)
+    {
+        return or_(and_(mask, a), andnot(mask, b));
+    }
+
+    template <int N>
+    hydra_inline Vector sra(Vector v)
+    {
+        return map(v, v, [](int16_t x, int16_t) { return x >> N; });
+    }
+
+    template <int N>
+    hydra_inline Vector srl(Vector v)
+    {
+        return map(v, v, [](uint16_t x, uint16_t) { return x >> N; });
+    }
+
+    template <int N>
+    hydra_inline Vector sll(Vector v)
+    {
+        return map(v, v, [](uint16_t x, uint16_t) { return x << N; });
+    }
+
+    // Clamps the 32-bit values high:low to int16_t
+    hydra_inline Vector clamp_signed(Vector high, Vector low)
+    {
+        return map(high, low, [](uint16_t x, uint16_t y) {
+            return saturate(static_cast<int32_t>((uint32_t(x) << 16) | y));
+        });
+    }
+
+    hydra_inline uint8_t to_bits(Vector mask)
+    {
+        uint8_t bits = 0;
+        for (int i = 0; i < 8; i++)
+        {
+            bits |= (mask.lanes[i] & 1) << i;
+        }
+        return bits;
+    }
+
+    hydra_inline Vector from_bits(uint8_t bits)
+    {
+        Vector result;
+        for (int i = 0; i < 8; i++)
+        {
+            result.lanes[i] = mask_of((bits >> i) & 1);
+        }
+        return result;
+    }
+#endif
+
+    hydra_inline Vector sign(Vector v)
+    {
+        return sra<15>(v);
+    }
+
+    hydra_inline Vector neg(Vector v)
+    {
+        return sub(zero(), v);
+    }
+} // namespace hydra::N64::simd
@@ -0,0 +1,142 @@
+#include <algorithm>
+#include <log.hxx>
+#include <n64/core/n64_scheduler.hxx>
+
+// std::*_heap builds a max-heap, invert the comparison to keep the earliest event in front
+static bool event_compare(const hydra::N64::SchedulerEvent& lhs,
+                          const hydra::N64::SchedulerEvent& rhs)
+{
+    return lhs.time > rhs.time;
+}
+
+namespace hydra::N64
+{
+    Scheduler::Scheduler()
+    {
+        events_.reserve(static_cast<size_t>(SchedulerEventType::Count));
+    }
+
+    void Scheduler::Reset()
+    {
+        time_ = 0;
+        serviced_event_time_ = 0;
+        events_.clear();
+        update_next_event_time();
+    }
+
+    void Scheduler::SaveState(StateWriter& writer) const
+    {
+        writer.Write(time_);
+        writer.Write(static_cast<uint32_t>(events_.size()));
+        // Field by field, SchedulerEvent's padding would make identical states differ
+        for (const SchedulerEvent& event : events_)
+        {
+            writer.Write(event.time);
+            writer.Write(static_cast<uint8_t>(event.type));
+        }
+    }
+
+    void Scheduler::LoadState(StateReader& reader)
+    {
+        uint32_t count = 0;
+        reader.Read(time_);
+        reader.Read(count);
+        // Every event type is pending at most once
+        if (count > static_cast<uint32_t>(SchedulerEventType::Count))
+        {
+            reader.Fail();
+            return;
+        }
+        events_.clear();
+        uint32_t seen = 0;
+        for (uint32_t i = 0; i < count; i++)
+        {
+            uint64_t time = 0;
+            uint8_t type = 0;
+            reader.Read(time);
+            reader.Read(type);
+            if (type >= static_cast<uint8_t>(SchedulerEventType::Count) || (seen & (1u << type)))
+            {
+                events_.clear();
+                reader.Fail();
+                break;
+            }
+            seen |= 1u << type;
+            events_.push_back({time, static_cast<SchedulerEventType>(type)});
+        }
+        std::make_heap(events_.begin(), events_.end(), event_compare);
+        update_next_event_time();
+    }
+
+    void Scheduler::SetEventCallback(SchedulerEventType type, std::function<void()> callback)
+    {
+        callbacks_[static_cast<size_t>(type)] = callback;
+    }
+
+    void Scheduler::Schedule(SchedulerEventType type, uint64_t delay)
+    {
+        schedule_at(type, time_ + delay);
+    }
+
+    void Scheduler::ScheduleFromDeadline(SchedulerEventType type, uint64_t delay)
+    {
+        schedule_at(type, serviced_event_time_ + delay);
+    }
+
+    void Scheduler::schedule_at(SchedulerEventType type, uint64_t time)
+    {
+        remove_event(type);
+        events_.push_back({time, type});
+        std::push_heap(events_.begin(), events_.end(), event_compare);
+        update_next_event_time();
+    }
+
+    void Scheduler::Deschedule(SchedulerEventType type)
+    {
+        remove_event(type);
+        update_next_event_time();
+    }
+
+    bool Scheduler::IsScheduled(SchedulerEventType type)
+    {
+        return std::any_of(events_.begin(), events_.end(),
+                           [type](const SchedulerEvent& event) { return event.type == type; });
+    }
+
+    void Scheduler::ServiceEvents()
+    {
+        while (!events_.empty() && events_.front().time <= time_)
+        {
+            std::pop_heap(events_.begin(), events_.end(), event_compare);
+            SchedulerEventType type = events_.back().type;
+            serviced_event_time_ = events_.back().time;
+            events_.pop_back();
+            update_next_event_time();
+
+            auto& callback = callbacks_[static_cast<size_t>(type)];
+            if (!callback)
+            {
+                Logger::Fatal("Scheduler: No callback for event {}", static_cast<int>(type));
+            }
+            // The callback is free to reschedule itself or any other event
+            callback();
+        }
+    }
+
+    void Scheduler::remove_event(SchedulerEventType type)
+    {
+        auto it = std::find_if(events_.begin(), events_.end(),
+                               [type](const SchedulerEvent& event) { return event.type == type; });
+        if (it != events_.end())
+        {
+            events_.erase(it);
+            std::make_heap(events_.begin(), events_.end(), event_compare);
+        }
+    }
+
+    void Scheduler::update_next_event_time()
+    {
+        next_event_time_ =
+            events_.empty() ? std::numeric_limits<uint64_t>::max() : events_.front().time;
+    }
+} // namespace hydra::N64
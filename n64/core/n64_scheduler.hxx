@@ -0,0 +1,80 @@
+#pragma once
+
+#include <array>
+#include <compatibility.hxx>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <state.hxx>
+#include <vector>
+
+namespace hydra::N64
+{
+    enum class SchedulerEventType
+    {
+        VI,
+        AI,
+        Compare,
+        PI,
+        SI,
+        RSP,
+        Count
+    };
+
+    struct SchedulerEvent
+    {
+        uint64_t time;
+        SchedulerEventType type;
+    };
+
+    // Keeps a min-heap of timestamped events so the CPU can run uninterrupted until the next one
+    // is due. Each event type is pending at most once, scheduling it again replaces the old one.
+    class Scheduler final
+    {
+    public:
+        Scheduler();
+        void Reset();
+        void SaveState(StateWriter& writer) const;
+        void LoadState(StateReader& reader);
+        void SetEventCallback(SchedulerEventType type, std::function<void()> callback);
+        void Schedule(SchedulerEventType type, uint64_t delay);
+        // Only valid from an event callback. Counts the delay from when the event being serviced
+        // was due instead of from now, so periodic events don't drift when servicing runs late
+        void ScheduleFromDeadline(SchedulerEventType type, uint64_t delay);
+        void Deschedule(SchedulerEventType type);
+        bool IsScheduled(SchedulerEventType type);
+        void ServiceEvents();
+
+        uint64_t GetTime() const
+        {
+            return time_;
+        }
+
+        hydra_inline void Tick()
+        {
+            ++time_;
+        }
+
+        hydra_inline void Advance(uint64_t cycles)
+        {
+            time_ += cycles;
+        }
+
+        hydra_inline bool ShouldService() const
+        {
+            return time_ >= next_event_time_;
+        }
+
+    private:
+        uint64_t time_ = 0;
+        uint64_t next_event_time_ = std::numeric_limits<uint64_t>::max();
+        uint64_t serviced_event_time_ = 0;
+        std::vector<SchedulerEvent> events_;
+        std::array<std::function<void()>, static_cast<size_t>(SchedulerEventType::Count)>
+            callbacks_;
+
+        void schedule_at(SchedulerEventType type, uint64_t time);
+        void remove_event(SchedulerEventType type);
+        void update_next_event_time();
+    };
+} // namespace hydra::N64
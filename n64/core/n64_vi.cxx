@@ -2,65 +2,299 @@
 #include <fmt/format.h>
 #include <log.hxx>
 #include <n64/core/n64_addresses.hxx>
+#include <n64/core/n64_profiler.hxx>
 #include <n64/core/n64_types.hxx>
 #include <n64/core/n64_vi.hxx>
 
+#if defined(__AVX2__)
+#define HYDRA_VI_AVX2
+#include <immintrin.h>
+#elif defined(__SSSE3__) || defined(_M_X64)
+#define HYDRA_VI_SSE
+#include <tmmintrin.h>
+#elif defined(__aarch64__) || defined(__arm64__)
+#define HYDRA_VI_NEON
+#include <arm_neon.h>
+#endif
+
+namespace
+{
+    // Big endian RGBA8888 to the frontend's RGBA8888
+    void convert_rgba8888_row(const uint8_t* src, uint8_t* dst, size_t count)
+    {
+        size_t i = 0;
+#if defined(HYDRA_VI_AVX2)
+        const __m256i swap = _mm256_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+                                              3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+        for (; i + 8 <= count; i += 8)
+        {
+            __m256i pixels = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i * 4));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i * 4),
+                                _mm256_shuffle_epi8(pixels, swap));
+        }
+#elif defined(HYDRA_VI_SSE)
+        const __m128i swap = _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+        for (; i + 4 <= count; i += 4)
+        {
+            __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 4));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 4),
+                             _mm_shuffle_epi8(pixels, swap));
+        }
+#elif defined(HYDRA_VI_NEON)
+        for (; i + 4 <= count; i += 4)
+        {
+            vst1q_u8(dst + i * 4, vrev32q_u8(vld1q_u8(src + i * 4)));
+        }
+#endif
+        for (; i < count; i++)
+        {
+            uint32_t color;
+            memcpy(&color, src + i * 4, 4);
+            color = hydra::bswap32(color);
+            memcpy(dst + i * 4, &color, 4);
+        }
+    }
+
+    // For frontends that take RGBA5551 as the N64 stores it
+    void copy_rgba5551_row(const uint8_t* src, uint8_t* dst, size_t count)
+    {
+        memcpy(dst, src, count * 2);
+    }
+
+    // Big endian RGBA5551 to RGBA8888, with the 5 bit channels widened by repeating their top bits
+    // and alpha always opaque
+    void convert_rgba5551_row(const uint8_t* src, uint8_t* dst, size_t count)
+    {
+        size_t i = 0;
+#if defined(HYDRA_VI_AVX2)
+        const __m256i swap = _mm256_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14,
+                                              1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+        const __m256i high = _mm256_set1_epi16(0xF8);
+        const __m256i low = _mm256_set1_epi16(0x7);
+        const __m256i alpha = _mm256_set1_epi16(static_cast<int16_t>(0xFF00));
+        for (; i + 16 <= count; i += 16)
+        {
+            __m256i c = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i * 2));
+            c = _mm256_shuffle_epi8(c, swap);
+            __m256i r = _mm256_or_si256(_mm256_and_si256(_mm256_srli_epi16(c, 8), high),
+                                        _mm256_and_si256(_mm256_srli_epi16(c, 13), low));
+            __m256i g = _mm256_or_si256(_mm256_and_si256(_mm256_srli_epi16(c, 3), high),
+                                        _mm256_and_si256(_mm256_srli_epi16(c, 8), low));
+            __m256i b = _mm256_or_si256(_mm256_and_si256(_mm256_slli_epi16(c, 2), high),
+                                        _mm256_and_si256(_mm256_srli_epi16(c, 3), low));
+            __m256i rg = _mm256_or_si256(r, _mm256_slli_epi16(g, 8));
+            __m256i ba = _mm256_or_si256(b, alpha);
+            // Unpacking works within 128 bit halves, so the results come out as pixels 0-3 and
+            // 8-11 followed by 4-7 and 12-15
+            __m256i lo = _mm256_unpacklo_epi16(rg, ba);
+            __m256i hi = _mm256_unpackhi_epi16(rg, ba);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i * 4),
+                                _mm256_permute2x128_si256(lo, hi, 0x20));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i * 4 + 32),
+                                _mm256_permute2x128_si256(lo, hi, 0x31));
+        }
+#elif defined(HYDRA_VI_SSE)
+        const __m128i swap = _mm_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+        const __m128i high = _mm_set1_epi16(0xF8);
+        const __m128i low = _mm_set1_epi16(0x7);
+        const __m128i alpha = _mm_set1_epi16(static_cast<int16_t>(0xFF00));
+        for (; i + 8 <= count; i += 8)
+        {
+            __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 2));
+            c = _mm_shuffle_epi8(c, swap);
+            __m128i r = _mm_or_si128(_mm_and_si128(_mm_srli_epi16(c, 8), high),
+                                     _mm_and_si128(_mm_srli_epi16(c, 13), low));
+            __m128i g = _mm_or_si128(_mm_and_si128(_mm_srli_epi16(c, 3), high),
+                                     _mm_and_si128(_mm_srli_epi16(c, 8), low));
+            __m128i b = _mm_or_si128(_mm_and_si128(_mm_slli_epi16(c, 2), high),
+                                     _mm_and_si128(_mm_srli_epi16(c, 3), low));
+            __m128i rg = _mm_or_si128(r, _mm_slli_epi16(g, 8));
+            __m128i ba = _mm_or_si128(b, alpha);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 4), _mm_unpacklo_epi16(rg, ba));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 4 + 16),
+                             _mm_unpackhi_epi16(rg, ba));
+        }
+#elif defined(HYDRA_VI_NEON)
+        const uint16x8_t high = vdupq_n_u16(0xF8);
+        const uint16x8_t low = vdupq_n_u16(0x7);
+        const uint16x8_t alpha = vdupq_n_u16(0xFF00);
+        for (; i + 8 <= count; i += 8)
+        {
+            uint16x8_t c = vreinterpretq_u16_u8(vrev16q_u8(vld1q_u8(src + i * 2)));
+            uint16x8_t r = vorrq_u16(vandq_u16(vshrq_n_u16(c, 8), high),
+                                     vandq_u16(vshrq_n_u16(c, 13), low));
+            uint16x8_t g = vorrq_u16(vandq_u16(vshrq_n_u16(c, 3), high),
+                                     vandq_u16(vshrq_n_u16(c, 8), low));
+            uint16x8_t b = vorrq_u16(vandq_u16(vshlq_n_u16(c, 2), high),
+                                     vandq_u16(vshrq_n_u16(c, 3), low));
+            uint16x8x2_t pixels = vzipq_u16(vorrq_u16(r, vshlq_n_u16(g, 8)), vorrq_u16(b, alpha));
+            vst1q_u16(reinterpret_cast<uint16_t*>(dst + i * 4), pixels.val[0]);
+            vst1q_u16(reinterpret_cast<uint16_t*>(dst + i * 4 + 16), pixels.val[1]);
+        }
+#endif
+        for (; i < count; i++)
+        {
+            uint16_t color_temp;
+            memcpy(&color_temp, src + i * 2, 2);
+            color_temp = hydra::bswap16(color_temp);
+            uint8_t r = (color_temp >> 11) & 0x1F;
+            uint8_t g = (color_temp >> 6) & 0x1F;
+            uint8_t b = (color_temp >> 1) & 0x1F;
+            r = (r << 3) | (r >> 2);
+            g = (g << 3) | (g >> 2);
+            b = (b << 3) | (b >> 2);
+            uint32_t color = 0xffu << 24 | b << 16 | g << 8 | r;
+            memcpy(dst + i * 4, &color, 4);
+        }
+    }
+} // namespace
+
 namespace hydra::N64
 {
     void Vi::Reset()
     {
         vi_v_intr_ = 0x100;
+        framebuffer_dirty_ = true;
+    }
+
+    void Vi::SaveState(StateWriter& writer) const
+    {
+        writer.Write(vi_ctrl_);
+        writer.Write(vi_origin_);
+        writer.Write(vi_width_);
+        writer.Write(vi_v_intr_);
+        writer.Write(vi_v_current_);
+        writer.Write(vi_burst_);
+        writer.Write(vi_v_sync_);
+        writer.Write(vi_h_sync_);
+        writer.Write(vi_h_sync_leap_);
+        writer.Write(vi_h_start_);
+        writer.Write(vi_h_end_);
+        writer.Write(vi_v_start_);
+        writer.Write(vi_v_end_);
+        writer.Write(vi_v_burst_);
+        writer.Write(vi_x_scale_);
+        writer.Write(vi_y_scale_);
+        writer.Write(width_);
+        writer.Write(height_);
+        writer.Write(num_halflines_);
+        writer.Write(cycles_per_halfline_);
+        writer.Write(pixel_mode_);
+    }
+
+    void Vi::LoadState(StateReader& reader)
+    {
+        framebuffer_dirty_ = true;
+        reader.Read(vi_ctrl_);
+        reader.Read(vi_origin_);
+        reader.Read(vi_width_);
+        reader.Read(vi_v_intr_);
+        reader.Read(vi_v_current_);
+        reader.Read(vi_burst_);
+        reader.Read(vi_v_sync_);
+        reader.Read(vi_h_sync_);
+        reader.Read(vi_h_sync_leap_);
+        reader.Read(vi_h_start_);
+        reader.Read(vi_h_end_);
+        reader.Read(vi_v_start_);
+        reader.Read(vi_v_end_);
+        reader.Read(vi_v_burst_);
+        reader.Read(vi_x_scale_);
+        reader.Read(vi_y_scale_);
+        reader.Read(width_);
+        reader.Read(height_);
+        reader.Read(num_halflines_);
+        reader.Read(cycles_per_halfline_);
+        reader.Read(pixel_mode_);
     }
 
-    void Vi::Redraw(std::vector<uint8_t>& data)
+    int Vi::Redraw(std::vector<uint8_t>& data, bool convert_16bpp)
     {
-        auto new_width = vi_h_end_ - vi_h_start_;
-        auto new_height = (vi_v_end_ - vi_v_start_) / 2;
-        new_width *= vi_x_scale_ ? vi_x_scale_ : 512;
-        new_height *= vi_y_scale_ ? vi_y_scale_ : 512;
-        new_width >>= 10;
-        new_height >>= 10;
-        width_ = new_width;
-        height_ = new_height;
-        size_t new_size = width_ * height_ * 4;
-        data.resize(new_size);
+        N64_PROFILE_SCOPE(VI);
+        width_ = frame_width();
+        height_ = frame_height();
+
+        // Games running below 60fps show each frame more than once, those repeats are skipped
+        Scanout scanout{vi_origin_, vi_width_, width_, height_, pixel_mode_, convert_16bpp};
+        if (scanout == last_scanout_ && !framebuffer_dirty_.load(std::memory_order_relaxed))
+        {
+            return 0;
+        }
+        last_scanout_ = scanout;
+
+        void (*convert_row)(const uint8_t*, uint8_t*, size_t);
+        size_t bytes_per_pixel;
+        size_t out_bytes_per_pixel = 4;
         switch (pixel_mode_)
         {
             case 0b11:
             {
-                for (int y = 0; y < height_; y++)
-                {
-                    for (int x = 0; x < width_; x++)
-                    {
-                        uint32_t color = hydra::bswap32((reinterpret_cast<uint32_t*>(
-                            &rdram_ptr_[vi_origin_]))[(y * vi_width_) + x]);
-                        memcpy(&data[(x + y * width_) * 4], &color, 4);
-                    }
-                }
+                convert_row = convert_rgba8888_row;
+                bytes_per_pixel = 4;
                 break;
             }
             case 0b10:
             {
-                for (int y = 0; y < height_; y++)
-                {
-                    for (int x = 0; x < width_; x++)
-                    {
-                        uint16_t color_temp = hydra::bswap16((reinterpret_cast<uint16_t*>(
-                            &rdram_ptr_[vi_origin_]))[(y * vi_width_) + x]);
-                        uint8_t r = (color_temp >> 11) & 0x1F;
-                        uint8_t g = (color_temp >> 6) & 0x1F;
-                        uint8_t b = (color_temp >> 1) & 0x1F;
-                        r = (r << 3) | (r >> 2);
-                        g = (g << 3) | (g >> 2);
-                        b = (b << 3) | (b >> 2);
-                        uint32_t color = 0xffu << 24 | b << 16 | g << 8 | r;
-                        memcpy(&data[(x + y * width_) * 4], &color, 4);
-                    }
-                }
+                convert_row = convert_16bpp ? convert_rgba5551_row : copy_rgba5551_row;
+                bytes_per_pixel = 2;
+                out_bytes_per_pixel = convert_16bpp ? 4 : 2;
                 break;
             }
             default:
-                break;
+                scanout_size_.store(0, std::memory_order_relaxed);
+                framebuffer_dirty_.store(false, std::memory_order_relaxed);
+                // Blanked, data may be a reused buffer still holding an older frame
+                data.assign(width_ * height_ * 4, 0);
+                return 4;
+        }
+
+        // Writes from here on mark the next frame dirty, even ones that race with the copy below
+        scanout_start_.store(vi_origin_, std::memory_order_relaxed);
+        scanout_size_.store(vi_width_ * height_ * bytes_per_pixel, std::memory_order_relaxed);
+        framebuffer_dirty_.store(false, std::memory_order_relaxed);
+
+        data.resize(width_ * height_ * out_bytes_per_pixel);
+        const uint8_t* src = &rdram_ptr_[vi_origin_];
+        if (vi_width_ == static_cast<uint32_t>(width_))
+        {
+            // No padding between rows, the whole frame converts in one go
+            convert_row(src, data.data(), static_cast<size_t>(width_) * height_);
+        }
+        else
+        {
+            for (int y = 0; y < height_; y++)
+            {
+                convert_row(src + y * vi_width_ * bytes_per_pixel,
+                            &data[y * width_ * out_bytes_per_pixel], width_);
+            }
+        }
+        return out_bytes_per_pixel;
+    }
+
+    int Vi::frame_width() const
+    {
+        uint32_t width = vi_h_end_ - vi_h_start_;
+        width *= vi_x_scale_ ? vi_x_scale_ : 512;
+        return width >> 10;
+    }
+
+    int Vi::frame_height() const
+    {
+        uint32_t height = (vi_v_end_ - vi_v_start_) / 2;
+        height *= vi_y_scale_ ? vi_y_scale_ : 512;
+        return height >> 10;
+    }
+
+    uint32_t Vi::ScanoutSize() const
+    {
+        switch (pixel_mode_)
+        {
+            case 0b11:
+                return vi_width_ * frame_height() * 4;
+            case 0b10:
+                return vi_width_ * frame_height() * 2;
+            default:
+                return 0;
         }
     }
 
@@ -1,7 +1,9 @@
 #pragma once
 
+#include <atomic>
 #include <cstdint>
 #include <functional>
+#include <state.hxx>
 #include <vector>
 
 namespace hydra::N64
@@ -14,13 +16,50 @@ namespace hydra::N64
     struct Vi
     {
         void Reset();
-        void Redraw(std::vector<uint8_t>& data);
+        void SaveState(StateWriter& writer) const;
+        void LoadState(StateReader& reader);
+        // Returns the bytes per pixel written to data. 16 bit framebuffers are copied as they are
+        // unless convert_16bpp is set, everything else ends up as RGBA8888. Returns 0 without
+        // touching data if the frame would be the same as the last one
+        int Redraw(std::vector<uint8_t>& data, bool convert_16bpp);
+
+        // Everything that writes to RDRAM reports it here, so frames can tell whether the memory
+        // they scan out changed since the last one. Safe to call from any thread
+        void MarkWritten(uint32_t address, uint32_t size)
+        {
+            uint32_t start = scanout_start_.load(std::memory_order_relaxed);
+            if (address - start < scanout_size_.load(std::memory_order_relaxed) ||
+                start - address < size) [[unlikely]]
+            {
+                framebuffer_dirty_.store(true, std::memory_order_relaxed);
+            }
+        }
+
+        // The RDRAM range Redraw would read with the current registers, empty while blanked
+        uint32_t ScanoutAddress() const
+        {
+            return vi_origin_;
+        }
+        uint32_t ScanoutSize() const;
+
         uint32_t ReadWord(uint32_t addr);
         void WriteWord(uint32_t addr, uint32_t data);
         void InstallBuses(uint8_t* rdram_ptr);
         void SetInterruptCallback(std::function<void(bool)> callback);
 
     private:
+        // Everything that decides what a frame looks like besides the memory it reads
+        struct Scanout
+        {
+            uint32_t origin = 0;
+            uint32_t vi_width = 0;
+            int width = 0, height = 0;
+            uint8_t pixel_mode = 0;
+            bool convert_16bpp = false;
+
+            bool operator==(const Scanout&) const = default;
+        };
+
         uint32_t vi_ctrl_ = 0;
         uint32_t vi_origin_ = 0;
         uint32_t vi_width_ = 0;
@@ -43,9 +82,16 @@ namespace hydra::N64
         int cycles_per_halfline_ = 1000;
 
         uint8_t pixel_mode_ = 0;
+        Scanout last_scanout_{};
+        std::atomic<uint32_t> scanout_start_ = 0;
+        std::atomic<uint32_t> scanout_size_ = 0;
+        std::atomic<bool> framebuffer_dirty_ = true;
         uint8_t* rdram_ptr_ = nullptr;
         std::function<void(bool)> interrupt_callback_;
 
+        int frame_width() const;
+        int frame_height() const;
+
         friend class hydra::N64::RCP;
         friend class hydra::N64::CPU;
         friend class hydra::N64::CPUBus;
@@ -0,0 +1,88 @@
+#include <algorithm>
+#include <n64/core/n64_worker_pool.hxx>
+
+constexpr uint32_t MAX_WORKERS = 8;
+
+namespace hydra::N64
+{
+    WorkerPool::WorkerPool(uint32_t worker_count)
+    {
+        if (worker_count == 0)
+        {
+            // Leave a hardware thread for the CPU thread that feeds us
+            uint32_t hardware_threads = std::thread::hardware_concurrency();
+            worker_count = std::clamp(hardware_threads > 1 ? hardware_threads - 1 : 1, 1u,
+                                      MAX_WORKERS);
+        }
+
+        for (uint32_t i = 1; i < worker_count; i++)
+        {
+            threads_.emplace_back(&WorkerPool::worker_loop, this, i);
+        }
+    }
+
+    WorkerPool::~WorkerPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            exit_ = true;
+        }
+        start_cv_.notify_all();
+
+        for (auto& thread : threads_)
+        {
+            thread.join();
+        }
+    }
+
+    void WorkerPool::Run(const std::function<void(uint32_t)>& task)
+    {
+        if (threads_.empty())
+        {
+            task(0);
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            task_ = &task;
+            remaining_ = threads_.size();
+            generation_++;
+        }
+        start_cv_.notify_all();
+
+        task(0);
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        done_cv_.wait(lock, [this] { return remaining_ == 0; });
+        task_ = nullptr;
+    }
+
+    void WorkerPool::worker_loop(uint32_t worker)
+    {
+        uint64_t seen_generation = 0;
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (true)
+        {
+            start_cv_.wait(lock, [this, seen_generation] {
+                return exit_ || generation_ != seen_generation;
+            });
+
+            if (exit_)
+            {
+                return;
+            }
+
+            seen_generation = generation_;
+            const std::function<void(uint32_t)>* task = task_;
+            lock.unlock();
+            (*task)(worker);
+            lock.lock();
+
+            if (--remaining_ == 0)
+            {
+                done_cv_.notify_one();
+            }
+        }
+    }
+} // namespace hydra::N64
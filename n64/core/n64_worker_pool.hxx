@@ -0,0 +1,42 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace hydra::N64
+{
+    // A fixed set of threads that run the same task side by side. Run blocks until every worker
+    // has returned, and the calling thread takes part as worker 0
+    class WorkerPool final
+    {
+    public:
+        // A worker count of 0 picks one based on the host's hardware threads
+        explicit WorkerPool(uint32_t worker_count = 0);
+        ~WorkerPool();
+        WorkerPool(const WorkerPool&) = delete;
+        WorkerPool& operator=(const WorkerPool&) = delete;
+
+        void Run(const std::function<void(uint32_t)>& task);
+
+        uint32_t WorkerCount() const
+        {
+            return threads_.size() + 1;
+        }
+
+    private:
+        std::vector<std::thread> threads_;
+        std::mutex mutex_;
+        std::condition_variable start_cv_;
+        std::condition_variable done_cv_;
+        const std::function<void(uint32_t)>* task_ = nullptr;
+        uint64_t generation_ = 0;
+        uint32_t remaining_ = 0;
+        bool exit_ = false;
+
+        void worker_loop(uint32_t worker);
+    };
+} // namespace hydra::N64
@@ -28,6 +28,36 @@ namespace hydra
         impl_.Reset();
     }
 
+    bool HydraCore_N64::SaveState(std::vector<uint8_t>& buffer)
+    {
+        return impl_.SaveState(buffer);
+    }
+
+    bool HydraCore_N64::LoadState(std::span<const uint8_t> state)
+    {
+        return impl_.LoadState(state);
+    }
+
+    void HydraCore_N64::SetRSPThreaded(bool threaded)
+    {
+        impl_.SetRSPThreaded(threaded);
+    }
+
+    void HydraCore_N64::SetRDPThreaded(bool threaded)
+    {
+        impl_.SetRDPThreaded(threaded);
+    }
+
+    void HydraCore_N64::SetFastmem(bool enabled)
+    {
+        impl_.SetFastmem(enabled);
+    }
+
+    void HydraCore_N64::SetFrameskip(int frames)
+    {
+        impl_.SetFrameskip(frames);
+    }
+
     void HydraCore_N64::SetVideoCallback(std::function<void(const VideoInfo&)> callback)
     {
         video_callback_ = callback;
@@ -37,11 +67,20 @@ namespace hydra
     {
         impl_.RunFrame();
 
-        hydra::VideoInfo vi;
+        hydra::VideoInfo& vi = acquire_video_buffer();
+        int bytes_per_pixel =
+            impl_.IsFrameSkipped() ? 0 : impl_.RenderVideo(vi.data, !rgba5551_supported_);
+        vi.repeat = bytes_per_pixel == 0;
+        if (vi.repeat)
+        {
+            video_callback_(vi);
+            return;
+        }
         vi.width = impl_.GetWidth();
         vi.height = impl_.GetHeight();
-        vi.format = hydra::VideoFormat::RGBA8888;
-        impl_.RenderVideo(vi.data);
+        vi.stride = vi.width * bytes_per_pixel;
+        vi.format = bytes_per_pixel == 2 ? hydra::VideoFormat::RGBA5551
+                                         : hydra::VideoFormat::RGBA8888;
         video_callback_(vi);
     }
 
@@ -55,8 +94,9 @@ namespace hydra
     void HydraCore_N64::audio_callback_wrapper(const std::vector<int16_t>& in, int frequency_in)
     {
         hydra::AudioInfo ai;
+        ma_uint32 rate_out = static_cast<ma_uint32>(host_sample_rate_ * audio_rate_adjust_ + 0.5);
         ma_resampler_config config = ma_resampler_config_init(
-            ma_format_s16, 2, frequency_in, host_sample_rate_, ma_resample_algorithm_linear);
+            ma_format_s16, 2, frequency_in, rate_out, ma_resample_algorithm_linear);
         ma_resampler resampler;
 
         struct Deleter
@@ -13,10 +13,17 @@ namespace hydra
 
         bool LoadFile(const std::string& type, const std::string& path) override;
         void Reset() override;
+        bool SaveState(std::vector<uint8_t>& buffer) override;
+        bool LoadState(std::span<const uint8_t> state) override;
         void SetVideoCallback(std::function<void(const VideoInfo&)> callback) override;
         void SetAudioCallback(std::function<void(const AudioInfo&)> callback) override;
         void SetPollInputCallback(std::function<void()> callback) override;
         void SetReadInputCallback(std::function<int8_t(const InputInfo&)> callback) override;
+        void SetRSPThreaded(bool threaded);
+        void SetRDPThreaded(bool threaded);
+        void SetFastmem(bool enabled);
+        // For fast-forward and batch runs, see N64::SetFrameskip
+        void SetFrameskip(int frames);
 
     private:
         void run_frame() override;
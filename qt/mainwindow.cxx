@@ -10,6 +10,7 @@
 #include <iostream>
 #include <json.hpp>
 #include <log.hxx>
+#include <n64/core/n64_profiler.hxx>
 #include <QApplication>
 #include <QClipboard>
 #include <QGridLayout>
@@ -18,24 +19,31 @@
 #include <QKeySequence>
 #include <QMessageBox>
 #include <QSurfaceFormat>
-#include <QTimer>
 #include <settings.hxx>
 #include <sol/sol.hpp>
 #define STB_IMAGE_WRITE_IMPLEMENTATION
 #include <stb_image_write.hxx>
 
+// Frames of audio to keep queued, three device periods
+constexpr int AUDIO_QUEUE_TARGET = 48000 / 60 * 3;
+
+// Runs on the audio thread, which must never wait on the others. Whatever isn't filled in is
+// left silent
 void hungry_for_more(ma_device* device, void* out, const void*, ma_uint32 frames)
 {
     MainWindow* window = static_cast<MainWindow*>(device->pUserData);
-    std::unique_lock<std::mutex> lock(window->audio_mutex_);
-    if (window->queued_audio_.empty())
+    MainWindow::AudioQueue& queue = *window->audio_queue_;
+    if (window->audio_flush_.exchange(false))
     {
-        return;
+        queue.consumerClear();
+    }
+
+    size_t samples = frames * 2;
+    size_t read = queue.readBuff(static_cast<int16_t*>(out), samples);
+    if (read < samples && window->audio_active_.load(std::memory_order_relaxed))
+    {
+        window->audio_underruns_.fetch_add(1, std::memory_order_relaxed);
     }
-    frames = std::min(frames * 2, static_cast<ma_uint32>(window->queued_audio_.size()));
-    std::memcpy(out, window->queued_audio_.data(), frames * sizeof(int16_t));
-    window->queued_audio_.erase(window->queued_audio_.begin(),
-                                window->queued_audio_.begin() + frames);
 }
 
 MainWindow::MainWindow(QWidget* parent) : QMainWindow(parent)
@@ -63,9 +71,6 @@ MainWindow::MainWindow(QWidget* parent) : QMainWindow(parent)
     setWindowTitle("hydra");
     setWindowIcon(QIcon(":/images/hydra.png"));
 
-    emulator_timer_ = new QTimer(this);
-    connect(emulator_timer_, SIGNAL(timeout()), this, SLOT(emulator_frame()));
-
     TerminalWindow::Init();
     Logger::HookCallback("Fatal", [this](const std::string& fatal_msg) {
         printf("Fatal: %s\n", fatal_msg.c_str());
@@ -205,6 +210,11 @@ void MainWindow::create_actions()
     terminal_act_->setStatusTip("Open the terminal");
     terminal_act_->setIcon(QIcon(":/images/terminal.png"));
     connect(terminal_act_, &QAction::triggered, this, &MainWindow::open_terminal);
+#ifdef HYDRA_N64_PROFILER
+    profile_act_ = new QAction(tr("Save &profile"), this);
+    profile_act_->setStatusTip("Save the N64 profiler's recent frames as a Chrome trace");
+    connect(profile_act_, &QAction::triggered, this, &MainWindow::save_profile);
+#endif
     recent_act_ = new QAction(tr("&Recent files"), this);
     for (int i = 0; i < 10; i++)
     {
@@ -253,6 +263,11 @@ void MainWindow::create_menus()
     tools_menu_->addAction(terminal_act_);
     tools_menu_->addAction(scripts_act_);
     tools_menu_->addAction(shaders_act_);
+    if (profile_act_)
+    {
+        tools_menu_->addSeparator();
+        tools_menu_->addAction(profile_act_);
+    }
     help_menu_ = menuBar()->addMenu(tr("&Help"));
     help_menu_->addAction(about_act_);
 }
@@ -302,6 +317,11 @@ void MainWindow::keyPressEvent(QKeyEvent* event)
             input_state_[hydra::InputButton::Start] = 1;
             break;
         }
+        case Qt::Key_Backspace:
+        {
+            rewinding_ = true;
+            break;
+        }
     }
 }
 
@@ -341,6 +361,14 @@ void MainWindow::keyReleaseEvent(QKeyEvent* event)
             input_state_[hydra::InputButton::Start] = 0;
             break;
         }
+        case Qt::Key_Backspace:
+        {
+            if (!event->isAutoRepeat())
+            {
+                rewinding_ = false;
+            }
+            break;
+        }
     }
 }
 
@@ -386,8 +414,6 @@ void MainWindow::open_file()
 
 void MainWindow::open_file_impl(const std::string& path)
 {
-    std::unique_lock<std::mutex> elock(emulator_mutex_);
-    emulator_timer_->stop();
     std::filesystem::path pathfs(path);
 
     if (!std::filesystem::is_regular_file(pathfs))
@@ -404,6 +430,9 @@ void MainWindow::open_file_impl(const std::string& path)
     emulator_ = hydra::UiCommon::Create(type);
     if (!emulator_)
         throw ErrorFactory::generate_exception(__func__, __LINE__, "Failed to create emulator");
+    emulator_->SetVideoBufferCallback(
+        [this]() -> hydra::VideoInfo& { return video_buffers_.Back(); });
+    emulator_->SetRGBA5551Supported(true);
     emulator_->SetVideoCallback(
         std::bind(&MainWindow::video_callback, this, std::placeholders::_1));
     emulator_->SetAudioCallback(
@@ -415,11 +444,11 @@ void MainWindow::open_file_impl(const std::string& path)
         throw ErrorFactory::generate_exception(__func__, __LINE__, "Failed to open ROM");
     enable_emulation_actions(true);
     add_recent(path);
+    read_rewind_settings();
+    update_rewinder();
 
-    if (!paused_)
-    {
-        emulator_timer_->start();
-    }
+    runner_ = std::make_unique<hydra::CoreRunner>(std::bind(&MainWindow::run_frame, this));
+    runner_->SetPaused(paused_);
 }
 
 void MainWindow::open_settings()
@@ -428,7 +457,8 @@ void MainWindow::open_settings()
         if (!settings_open_)
         {
             using namespace std::placeholders;
-            new SettingsWindow(settings_open_, std::bind(&MainWindow::set_volume, this, _1), this);
+            new SettingsWindow(settings_open_, std::bind(&MainWindow::set_volume, this, _1),
+                               std::bind(&MainWindow::set_rewind_budget, this), this);
         }
     });
 }
@@ -520,7 +550,6 @@ void MainWindow::run_script(const std::string& script, bool safe_mode)
 
 void MainWindow::screenshot()
 {
-    std::unique_lock<std::mutex> elock(emulator_mutex_);
     std::filesystem::path screenshot_path = Settings::Get("screenshot_path");
     if (screenshot_path.empty())
     {
@@ -538,8 +567,22 @@ void MainWindow::screenshot()
 
     std::filesystem::path screenshot_full_path =
         screenshot_path / (screenshot_name + screenshot_extension);
-    stbi_write_png(screenshot_full_path.string().c_str(), video_info_.width, video_info_.height, 4,
-                   video_info_.data.data(), video_info_.width * 4);
+    const hydra::VideoInfo& frame = video_buffers_.Front();
+    std::vector<uint8_t> pixels;
+    hydra::UiCommon::ConvertToRGBA8888(frame, pixels);
+    stbi_write_png(screenshot_full_path.string().c_str(), frame.width, frame.height, 4,
+                   pixels.data(), frame.width * 4);
+}
+
+void MainWindow::save_profile()
+{
+#ifdef HYDRA_N64_PROFILER
+    QString path = QFileDialog::getSaveFileName(this, "Save profile", "", "Chrome trace (*.json)");
+    if (!path.isEmpty() && !hydra::N64::Profiler::WriteChromeTrace(path.toStdString()))
+    {
+        Logger::Warn("Failed to save profile: {}", path.toStdString());
+    }
+#endif
 }
 
 void MainWindow::set_volume(int volume)
@@ -547,6 +590,23 @@ void MainWindow::set_volume(int volume)
     ma_device_set_master_volume(&sound_device_, volume / 100.0f);
 }
 
+void MainWindow::set_rewind_budget()
+{
+    // The rewinder belongs to the runner's thread, it picks the new budget up on the next frame
+    read_rewind_settings();
+    rewind_budget_changed_ = true;
+}
+
+// Settings are only safe to access from the GUI thread, the runner reads these copies instead
+void MainWindow::read_rewind_settings()
+{
+    // Budget in megabytes, 0 disables rewinding
+    std::string budget_str = Settings::Get("rewind_budget");
+    rewind_budget_setting_ = budget_str.empty() ? 256 : std::stoi(budget_str);
+    std::string interval_str = Settings::Get("rewind_interval");
+    rewind_interval_setting_ = interval_str.empty() ? 10 : std::max(1, std::stoi(interval_str));
+}
+
 void MainWindow::open_about()
 {
     qt_may_throw([this]() {
@@ -593,23 +653,22 @@ void MainWindow::initialize_emulator_data()
 void MainWindow::pause_emulator()
 {
     paused_ = !paused_;
-    if (paused_)
-    {
-        emulator_timer_->stop();
-    }
-    else
+    if (runner_)
     {
-        emulator_timer_->start();
+        runner_->SetPaused(paused_);
     }
+    // Running dry while paused isn't an underrun
+    audio_active_ = false;
 }
 
 void MainWindow::reset_emulator()
 {
-    if (emulator_)
+    if (runner_)
     {
-        std::unique_lock<std::mutex> alock(audio_mutex_);
-        queued_audio_.clear();
-        emulator_->Reset();
+        runner_->Post([this]() {
+            audio_flush_ = true;
+            emulator_->Reset();
+        });
     }
 }
 
@@ -617,34 +676,118 @@ void MainWindow::stop_emulator()
 {
     if (emulator_)
     {
-        std::unique_lock<std::mutex> alock(audio_mutex_);
-        emulator_timer_->stop();
-        queued_audio_.clear();
+        runner_.reset();
+        audio_active_ = false;
+        audio_flush_ = true;
+        Logger::Info("Audio: {} underruns, {} overruns", audio_underruns_.exchange(0),
+                     audio_overruns_.exchange(0));
+        rewinder_.reset();
         emulator_.reset();
         enable_emulation_actions(false);
-        video_info_ = {};
+        // Keeps the allocation for the next game
+        hydra::VideoInfo& frame = video_buffers_.Front();
+        frame.data.clear();
+        frame.width = frame.height = frame.stride = 0;
     }
 }
 
-void MainWindow::emulator_frame()
+// Creates, resizes or destroys the rewinder to match the settings. Keeps the history when the
+// budget changes while a game is running
+void MainWindow::update_rewinder()
 {
-    std::unique_lock<std::mutex> elock(emulator_mutex_);
-    std::future<void> frame = emulator_->RunFrameAsync();
-    frame.wait();
+    int budget = rewind_budget_setting_;
+    rewind_interval_ = rewind_interval_setting_;
+    rewind_counter_ = 0;
+    if (budget <= 0)
+    {
+        rewinder_.reset();
+    }
+    else if (rewinder_)
+    {
+        rewinder_->SetBudget(static_cast<size_t>(budget) << 20);
+    }
+    else if (emulator_->SaveState(rewind_state_))
+    {
+        rewinder_ = std::make_unique<hydra::Rewinder>(static_cast<size_t>(budget) << 20);
+    }
+}
 
-    screen_->Redraw(video_info_.width, video_info_.height, video_info_.data.data());
+// Runs on the runner's thread
+void MainWindow::run_frame()
+{
+    if (rewind_budget_changed_.exchange(false))
+    {
+        update_rewinder();
+    }
+
+    if (rewinder_)
+    {
+        // While rewinding, step back a snapshot every frame instead of taking new ones
+        if (rewinding_)
+        {
+            if (rewinder_->Pop(rewind_state_))
+            {
+                emulator_->LoadState(rewind_state_);
+            }
+            rewind_counter_ = 0;
+        }
+        else if (++rewind_counter_ >= rewind_interval_)
+        {
+            rewind_counter_ = 0;
+            if (emulator_->SaveState(rewind_state_))
+            {
+                rewinder_->Push(rewind_state_);
+            }
+        }
+    }
+
+    emulator_->RunFrame();
+
+    // Frames finished while the GUI is busy replace each other instead of queueing up
+    if (!present_pending_.exchange(true))
+    {
+        QMetaObject::invokeMethod(this, &MainWindow::present_frame, Qt::QueuedConnection);
+    }
+}
+
+void MainWindow::present_frame()
+{
+    present_pending_ = false;
+    if (video_buffers_.Consume())
+    {
+        const hydra::VideoInfo& frame = video_buffers_.Front();
+        screen_->Redraw(frame);
+    }
 }
 
+// The frame was drawn straight into the back buffer, publishing it is all that's left. Repeats
+// aren't, so the GUI doesn't upload the same picture again
 void MainWindow::video_callback(const hydra::VideoInfo& vi)
 {
-    video_info_ = vi;
+    if (!vi.repeat)
+    {
+        video_buffers_.Publish();
+    }
 }
 
+// Runs on the runner's thread
 void MainWindow::audio_callback(const hydra::AudioInfo& ai)
 {
-    std::unique_lock<std::mutex> lock(audio_mutex_);
-    queued_audio_.reserve(queued_audio_.size() + ai.data.size());
-    queued_audio_.insert(queued_audio_.end(), ai.data.begin(), ai.data.end());
+    AudioQueue& queue = *audio_queue_;
+    size_t written = queue.writeBuff(ai.data.data(), ai.data.size());
+    if (written < ai.data.size())
+    {
+        audio_overruns_.fetch_add(1, std::memory_order_relaxed);
+    }
+    audio_active_.store(true, std::memory_order_relaxed);
+
+    // Resample slightly faster while the queue is below its target level and slower while it's
+    // above, so it settles there instead of drifting into underruns or overruns
+    constexpr double target = AUDIO_QUEUE_TARGET;
+    constexpr double max_adjust = 0.005;
+    double level = queue.readAvailable() / 2;
+    double error = std::clamp((target - level) / target, -1.0, 1.0);
+    emulator_->SetAudioRateAdjust(1.0 + error * max_adjust);
 }
 
 void MainWindow::poll_input_callback() {}
@@ -2,9 +2,14 @@
 
 #include "screenwidget.hxx"
 #include <array>
+#include <atomic>
 #include <core.hxx>
+#include <core_runner.hxx>
 #include <deque>
 #include <memory>
+#include <ringbuffer.hpp>
+#include <rewind.hxx>
+#include <triple_buffer.hxx>
 #include <ui_common.hxx>
 #define MA_NO_DECODING
 #define MA_NO_ENCODING
@@ -38,16 +43,21 @@ private:
     void open_terminal();
     void run_script(const std::string& script, bool safe_mode);
     void screenshot();
+    void save_profile();
     void add_recent(const std::string& path);
 
     // Emulation functions
     void pause_emulator();
     void reset_emulator();
     void stop_emulator();
+    void read_rewind_settings();
+    void update_rewinder();
+    void run_frame();
     void enable_emulation_actions(bool should);
     void initialize_emulator_data();
     void initialize_audio();
     void set_volume(int volume);
+    void set_rewind_budget();
     void update_recent_files();
 
     void video_callback(const hydra::VideoInfo& info);
@@ -56,7 +66,7 @@ private:
     int8_t read_input_callback(const hydra::InputInfo& info);
 
 private slots:
-    void emulator_frame();
+    void present_frame();
     void on_mouse_move(QMouseEvent* event);
 
 public:
@@ -79,25 +89,39 @@ public:
     QAction* shaders_act_;
     QAction* scripts_act_;
     QAction* terminal_act_;
+    QAction* profile_act_ = nullptr;
     QAction* recent_act_;
-    QTimer* emulator_timer_;
     ScreenWidget* screen_;
     ma_device sound_device_{};
     std::unique_ptr<hydra::Core> emulator_;
-    std::vector<int16_t> queued_audio_;
+    // Declared after emulator_ so it stops before the emulator is destroyed
+    std::unique_ptr<hydra::CoreRunner> runner_;
+    std::unique_ptr<hydra::Rewinder> rewinder_;
+    std::vector<uint8_t> rewind_state_;
+    int rewind_interval_ = 0;
+    int rewind_counter_ = 0;
+    std::atomic<bool> rewinding_ = false;
+    std::atomic<bool> rewind_budget_changed_ = false;
+    std::atomic<int> rewind_budget_setting_ = 0;
+    std::atomic<int> rewind_interval_setting_ = 1;
     hydra::EmuType emulator_type_;
-    std::thread emulator_thread_;
     bool settings_open_ = false;
     bool about_open_ = false;
     bool shaders_open_ = false;
     bool scripts_open_ = false;
     bool terminal_open_ = false;
     bool paused_ = false;
-    std::mutex emulator_mutex_;
-    std::mutex audio_mutex_;
-    hydra::VideoInfo video_info_;
+    // Interleaved stereo samples, written by the runner thread and read by the audio thread
+    using AudioQueue = jnk0le::Ringbuffer<int16_t, 0x4000, false, 64>;
+    std::unique_ptr<AudioQueue> audio_queue_ = std::make_unique<AudioQueue>();
+    std::atomic<bool> audio_flush_ = false;
+    std::atomic<bool> audio_active_ = false;
+    std::atomic<uint64_t> audio_underruns_ = 0;
+    std::atomic<uint64_t> audio_overruns_ = 0;
+    hydra::TripleBuffer<hydra::VideoInfo> video_buffers_;
+    std::atomic<bool> present_pending_ = false;
 
-    std::array<int8_t, hydra::InputButton::InputCount> input_state_{};
+    std::array<std::atomic<int8_t>, hydra::InputButton::InputCount> input_state_{};
     std::deque<std::string> recent_files_;
 
     friend void hungry_for_more(ma_device*, void*, const void*, ma_uint32);
@@ -1,8 +1,10 @@
 #include "screenwidget.hxx"
+#include <cstring>
 #include <iostream>
 #include <log.hxx>
 #include <QFile>
 #include <QSurfaceFormat>
+#include <ui_common.hxx>
 
 // clang-format off
 
@@ -28,20 +30,93 @@ ScreenWidget::~ScreenWidget()
 {
     if (initialized_)
     {
+        makeCurrent();
         glDeleteTextures(1, &texture_);
+        glDeleteBuffers(pbos_.size(), pbos_.data());
+        doneCurrent();
     }
     delete program_;
 }
 
-void ScreenWidget::Redraw(int width, int height, const void* tdata)
+void ScreenWidget::Redraw(const hydra::VideoInfo& frame)
 {
-    if (initialized_) [[likely]]
+    if (!initialized_) [[unlikely]]
     {
-        glBindTexture(GL_TEXTURE_2D, texture_);
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, tdata);
-        glBindTexture(GL_TEXTURE_2D, 0);
-        update();
+        return;
+    }
+
+    const uint8_t* data = frame.data.data();
+    uint32_t stride = frame.stride;
+    hydra::VideoFormat format = frame.format;
+    if (format == hydra::VideoFormat::RGBA5551 && rgba5551_uniform_ == -1)
+    {
+        hydra::UiCommon::ConvertToRGBA8888(frame, converted_);
+        data = converted_.data();
+        stride = frame.width * 4;
+        format = hydra::VideoFormat::RGBA8888;
+    }
+
+    makeCurrent();
+    glBindTexture(GL_TEXTURE_2D, texture_);
+    // Storage is only respecified when the frame changes shape, the rest are plain uploads
+    if (frame.width != texture_width_ || frame.height != texture_height_ ||
+        format != texture_format_)
+    {
+        texture_width_ = frame.width;
+        texture_height_ = frame.height;
+        texture_format_ = format;
+        if (format == hydra::VideoFormat::RGBA5551)
+        {
+            // Each texel holds the two bytes of a pixel, the fragment shader puts them together
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RG8, frame.width, frame.height, 0, GL_RG,
+                         GL_UNSIGNED_BYTE, nullptr);
+        }
+        else
+        {
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB8, frame.width, frame.height, 0, GL_RGBA,
+                         GL_UNSIGNED_BYTE, nullptr);
+        }
+    }
+    upload(data, stride, static_cast<size_t>(stride) * frame.height);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    doneCurrent();
+    update();
+}
+
+void ScreenWidget::upload(const uint8_t* data, uint32_t stride, size_t size)
+{
+    if (size == 0)
+    {
+        return;
+    }
+
+    bool rgba5551 = texture_format_ == hydra::VideoFormat::RGBA5551;
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbos_[pbo_index_]);
+    if (pbo_sizes_[pbo_index_] != size)
+    {
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, size, nullptr, GL_STREAM_DRAW);
+        pbo_sizes_[pbo_index_] = size;
+    }
+
+    void* mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size,
+                                    GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+    if (mapped)
+    {
+        memcpy(mapped, data, size);
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, rgba5551 ? 2 : 4);
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, stride / (rgba5551 ? 2 : 4));
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, texture_width_, texture_height_,
+                        rgba5551 ? GL_RG : GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    }
+    else
+    {
+        Logger::Warn("Failed to map pixel buffer");
     }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    pbo_index_ = (pbo_index_ + 1) % pbos_.size();
 }
 
 void ScreenWidget::ResetProgram(QString* vertex, QString* fragment)
@@ -98,6 +173,9 @@ void ScreenWidget::ResetProgram(QString* vertex, QString* fragment)
         Logger::Fatal("Could not find uniform tex");
     }
     glUniform1i(tex, 0);
+    rgba5551_uniform_ = glGetUniformLocation(program_->programId(), "rgba5551");
+    // The next frame respecifies the texture, in case the new shader takes another format
+    texture_width_ = texture_height_ = 0;
     delete fshader;
     delete vshader;
 }
@@ -124,6 +202,7 @@ void ScreenWidget::initializeGL()
     glEnableVertexAttribArray(1);
     glEnable(GL_TEXTURE_2D);
     glGenTextures(1, &texture_);
+    glGenBuffers(pbos_.size(), pbos_.data());
     glClearColor(0.1, 0, 0, 1);
     glClear(GL_COLOR_BUFFER_BIT);
     ResetProgram();
@@ -142,6 +221,11 @@ void ScreenWidget::paintGL()
     program_->bind();
     if (initialized_)
     {
+        if (rgba5551_uniform_ != -1)
+        {
+            glUniform1i(rgba5551_uniform_,
+                        texture_format_ == hydra::VideoFormat::RGBA5551 ? 1 : 0);
+        }
         glBindTexture(GL_TEXTURE_2D, texture_);
         glDrawArrays(GL_TRIANGLES, 0, 6);
         glBindTexture(GL_TEXTURE_2D, 0);
@@ -1,7 +1,9 @@
 #ifndef SCREENWIDGET_H
 #define SCREENWIDGET_H
+#include <array>
+#include <core.hxx>
 #include <QOpenGLBuffer>
-#include <QOpenGLFunctions>
+#include <QOpenGLExtraFunctions>
 #include <QOpenGLShader>
 #include <QOpenGLShaderProgram>
 #include <QOpenGLTexture>
@@ -9,15 +11,16 @@
 #include <QOpenGLWidget>
 #include <QResizeEvent>
 #include <QString>
+#include <vector>
 
-class ScreenWidget : public QOpenGLWidget, protected QOpenGLFunctions
+class ScreenWidget : public QOpenGLWidget, protected QOpenGLExtraFunctions
 {
     Q_OBJECT
 
 public:
     ScreenWidget(QWidget* parent = nullptr);
     ~ScreenWidget();
-    void Redraw(int width, int height, const void* data);
+    void Redraw(const hydra::VideoInfo& frame);
     void ResetProgram(QString* vertex = nullptr, QString* fragment = nullptr);
 
     void SetMouseMoveCallback(std::function<void(QMouseEvent*)> callback)
@@ -31,7 +34,17 @@ private:
     void initializeGL() override;
     void resizeGL(int width, int height) override;
     void paintGL() override;
+    void upload(const uint8_t* data, uint32_t stride, size_t size);
     GLuint texture_;
+    // Uploads alternate between these so writing a frame never waits on the previous upload
+    std::array<GLuint, 2> pbos_{};
+    std::array<size_t, 2> pbo_sizes_{};
+    size_t pbo_index_ = 0;
+    uint32_t texture_width_ = 0, texture_height_ = 0;
+    hydra::VideoFormat texture_format_ = hydra::VideoFormat::RGBA8888;
+    // -1 for shaders that can't unpack RGBA5551 texels, those get converted frames instead
+    GLint rgba5551_uniform_ = -1;
+    std::vector<uint8_t> converted_;
     QOpenGLShaderProgram* program_ = nullptr;
     QString vshader_source_;
     QString fshader_source_;
@@ -5,12 +5,14 @@
 #include <QFileDialog>
 #include <QLabel>
 #include <QPushButton>
+#include <QSpinBox>
 #include <QVBoxLayout>
 #include <settings.hxx>
 
 SettingsWindow::SettingsWindow(bool& open, std::function<void(int)> volume_callback,
-                               QWidget* parent)
-    : open_(open), volume_callback_(volume_callback), QWidget(parent, Qt::Window)
+                               std::function<void()> rewind_budget_callback, QWidget* parent)
+    : open_(open), volume_callback_(volume_callback),
+      rewind_budget_callback_(rewind_budget_callback), QWidget(parent, Qt::Window)
 {
     setFocusPolicy(Qt::StrongFocus);
     setAttribute(Qt::WA_DeleteOnClose);
@@ -108,6 +110,16 @@ void SettingsWindow::create_tabs()
         use_cwd->setCheckState(Settings::Get("screenshot_path").empty() ? Qt::Checked
                                                                         : Qt::Unchecked);
         general_layout->addWidget(use_cwd, 1, 0, 1, 2);
+        general_layout->addWidget(new QLabel("Rewind memory (MB, 0 disables):"), 2, 0);
+        QSpinBox* rewind_budget = new QSpinBox;
+        rewind_budget->setRange(0, 4096);
+        std::string budget_str = Settings::Get("rewind_budget");
+        rewind_budget->setValue(budget_str.empty() ? 256 : std::stoi(budget_str));
+        connect(rewind_budget, &QSpinBox::valueChanged, this, [this](int value) {
+            Settings::Set("rewind_budget", std::to_string(value));
+            rewind_budget_callback_();
+        });
+        general_layout->addWidget(rewind_budget, 2, 1);
     }
     {
         QGridLayout* audio_layout = new QGridLayout;
@@ -168,6 +180,18 @@ void SettingsWindow::create_tabs()
             n64_layout->addWidget(new QComboBox, i + 1, 1);
             n64_layout->addWidget(active, i + 1, 2);
         }
+        QCheckBox* rsp_thread = new QCheckBox("Run the RSP on a separate thread (needs restart)");
+        rsp_thread->setChecked(Settings::Get("n64_rsp_thread") == "true");
+        connect(rsp_thread, &QCheckBox::stateChanged, this, [](int state) {
+            Settings::Set("n64_rsp_thread", state == Qt::Checked ? "true" : "false");
+        });
+        n64_layout->addWidget(rsp_thread, 6, 0, 1, 3);
+        QCheckBox* rdp_thread = new QCheckBox("Render on a separate thread (needs restart)");
+        rdp_thread->setChecked(Settings::Get("n64_rdp_thread") != "false");
+        connect(rdp_thread, &QCheckBox::stateChanged, this, [](int state) {
+            Settings::Set("n64_rdp_thread", state == Qt::Checked ? "true" : "false");
+        });
+        n64_layout->addWidget(rdp_thread, 7, 0, 1, 3);
         QWidget* n64_tab = new QWidget;
         n64_tab->setLayout(n64_layout);
         tab_show_->addTab(n64_tab, "N64");
@@ -21,6 +21,7 @@ private:
     QLineEdit* ipl_path_;
     KeyPickerPage* key_picker_;
     std::function<void(int)> volume_callback_;
+    std::function<void()> rewind_budget_callback_;
     void create_tabs();
     void on_open_file_click(QLineEdit* edit, const std::string& name, const std::string& setting,
                             const std::string& extension);
@@ -32,6 +33,7 @@ private slots:
     void on_tab_change(int tab);
 
 public:
-    SettingsWindow(bool& open, std::function<void(int)> volume_callback, QWidget* parent = nullptr);
+    SettingsWindow(bool& open, std::function<void(int)> volume_callback,
+                   std::function<void()> rewind_budget_callback, QWidget* parent = nullptr);
     ~SettingsWindow();
 };
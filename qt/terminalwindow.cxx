@@ -10,8 +10,9 @@
 #include <QVBoxLayout>
 #include <settings.hxx>
 
+std::mutex TerminalWindow::logs_mutex_;
 std::unordered_map<std::string, std::string> TerminalWindow::logs_;
-bool TerminalWindow::changed_ = false;
+std::atomic<bool> TerminalWindow::changed_ = false;
 
 TerminalWindow::TerminalWindow(bool& open, QWidget* parent)
     : QWidget(parent, Qt::Window), open_(open)
@@ -31,7 +32,10 @@ TerminalWindow::TerminalWindow(bool& open, QWidget* parent)
     QAction* clear_action = toolbar->addAction("Clear");
     clear_action->setIcon(QIcon(":/images/trash.png"));
     connect(clear_action, &QAction::triggered, [this]() {
-        logs_[groups_combo_box_->currentText().toStdString()] = "";
+        {
+            std::lock_guard<std::mutex> lock(logs_mutex_);
+            logs_[groups_combo_box_->currentText().toStdString()] = "";
+        }
         on_group_changed(groups_combo_box_->currentText());
     });
     QAction* save_action = toolbar->addAction("Save");
@@ -99,18 +103,23 @@ TerminalWindow::~TerminalWindow()
 
 void TerminalWindow::on_group_changed(const QString& group)
 {
-    edit_->setText(QString::fromStdString(logs_[group.toStdString()]));
+    std::string text;
+    {
+        std::lock_guard<std::mutex> lock(logs_mutex_);
+        text = logs_[group.toStdString()];
+    }
+    edit_->setText(QString::fromStdString(text));
 }
 
 void TerminalWindow::on_timeout()
 {
-    if (changed_)
+    if (changed_.exchange(false))
         on_group_changed(groups_combo_box_->currentText());
-    changed_ = false;
 }
 
 void TerminalWindow::log(const std::string& group, const std::string& message)
 {
+    std::lock_guard<std::mutex> lock(logs_mutex_);
     logs_[group] += message;
     changed_ = true;
 }
@@ -3,6 +3,8 @@
 #include <QComboBox>
 #include <QTextEdit>
 #include <QWidget>
+#include <atomic>
+#include <mutex>
 #include <unordered_map>
 
 class TerminalWindow : public QWidget
@@ -24,6 +26,8 @@ private:
     void on_timeout();
 
     static void log(const std::string& group, const std::string& message);
+    // Written from whichever thread logs, read from the UI thread
+    static std::mutex logs_mutex_;
     static std::unordered_map<std::string, std::string> logs_;
-    static bool changed_;
+    static std::atomic<bool> changed_;
 };
\ No newline at end of file
@@ -3,9 +3,9 @@
 namespace hydra
 {
 
-    std::future<void> Core::RunFrameAsync()
+    void Core::RunFrame()
     {
-        return std::async(std::launch::async, [this]() { run_frame(); });
+        run_frame();
     }
 
 } // namespace hydra
\ No newline at end of file
@@ -0,0 +1,109 @@
+#include <core_runner.hxx>
+
+namespace
+{
+    // Sleeps are only accurate to a scheduler tick or so, the last stretch is spent yielding
+    constexpr auto SPIN_TIME = std::chrono::milliseconds(2);
+    // Frames this late are dropped from the schedule instead of being run back to back
+    constexpr int MAX_FRAMES_BEHIND = 4;
+} // namespace
+
+namespace hydra
+{
+    CoreRunner::CoreRunner(std::function<void()> frame, double frame_rate)
+        : frame_(std::move(frame)),
+          period_(std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+              std::chrono::duration<double>(1.0 / frame_rate)))
+    {
+        thread_ = std::thread(&CoreRunner::loop, this);
+    }
+
+    CoreRunner::~CoreRunner()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            quit_ = true;
+        }
+        cv_.notify_all();
+        thread_.join();
+    }
+
+    void CoreRunner::SetPaused(bool paused)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            paused_ = paused;
+        }
+        cv_.notify_all();
+    }
+
+    void CoreRunner::Post(std::function<void()> task)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            tasks_.push_back(std::move(task));
+        }
+        cv_.notify_all();
+    }
+
+    void CoreRunner::run_tasks(std::unique_lock<std::mutex>& lock)
+    {
+        while (!tasks_.empty())
+        {
+            std::vector<std::function<void()>> tasks;
+            tasks.swap(tasks_);
+            lock.unlock();
+            for (auto& task : tasks)
+            {
+                task();
+            }
+            lock.lock();
+        }
+    }
+
+    void CoreRunner::loop()
+    {
+        using clock = std::chrono::steady_clock;
+        auto deadline = clock::now();
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (true)
+        {
+            run_tasks(lock);
+            if (quit_)
+            {
+                return;
+            }
+
+            if (paused_)
+            {
+                cv_.wait(lock, [this] { return quit_ || !paused_ || !tasks_.empty(); });
+                deadline = clock::now();
+                continue;
+            }
+
+            auto now = clock::now();
+            if (now < deadline - SPIN_TIME)
+            {
+                // Tasks, pausing and quitting cut the sleep short without moving the deadline
+                cv_.wait_until(lock, deadline - SPIN_TIME,
+                               [this] { return quit_ || paused_ || !tasks_.empty(); });
+                continue;
+            }
+
+            lock.unlock();
+            while (clock::now() < deadline)
+            {
+                std::this_thread::yield();
+            }
+            frame_();
+            lock.lock();
+
+            deadline += period_;
+            now = clock::now();
+            if (now > deadline + period_ * MAX_FRAMES_BEHIND)
+            {
+                deadline = now;
+            }
+        }
+    }
+} // namespace hydra
@@ -0,0 +1,227 @@
+#include <algorithm>
+#include <cstring>
+#include <rewind.hxx>
+
+namespace
+{
+    void write_varint(std::vector<uint8_t>& out, size_t value)
+    {
+        while (value >= 0x80)
+        {
+            out.push_back(static_cast<uint8_t>(value) | 0x80);
+            value >>= 7;
+        }
+        out.push_back(static_cast<uint8_t>(value));
+    }
+
+    size_t read_varint(const uint8_t*& ptr)
+    {
+        size_t value = 0;
+        int shift = 0;
+        uint8_t byte;
+        do
+        {
+            byte = *ptr++;
+            value |= static_cast<size_t>(byte & 0x7F) << shift;
+            shift += 7;
+        } while (byte & 0x80);
+        return value;
+    }
+
+    uint64_t load64(const uint8_t* ptr)
+    {
+        uint64_t value;
+        std::memcpy(&value, ptr, sizeof(value));
+        return value;
+    }
+} // namespace
+
+namespace hydra
+{
+    Rewinder::Rewinder(size_t budget) : budget_(budget)
+    {
+        worker_ = std::thread(&Rewinder::worker_loop, this);
+    }
+
+    Rewinder::~Rewinder()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            quit_ = true;
+        }
+        worker_cv_.notify_one();
+        worker_.join();
+    }
+
+    void Rewinder::Push(std::vector<uint8_t>& state)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            std::swap(state, pending_);
+            has_pending_ = true;
+        }
+        worker_cv_.notify_one();
+    }
+
+    bool Rewinder::Pop(std::vector<uint8_t>& state)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        wait_idle(lock);
+        if (latest_.empty())
+        {
+            return false;
+        }
+
+        std::swap(state, latest_);
+        if (deltas_.empty())
+        {
+            latest_.clear();
+            return true;
+        }
+
+        latest_.assign(state.begin(), state.end());
+        apply(latest_, deltas_.back());
+        deltas_size_ -= deltas_.back().data.size();
+        deltas_.pop_back();
+        return true;
+    }
+
+    void Rewinder::Clear()
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        wait_idle(lock);
+        latest_.clear();
+        deltas_.clear();
+        deltas_size_ = 0;
+    }
+
+    void Rewinder::SetBudget(size_t budget)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        wait_idle(lock);
+        budget_ = budget;
+        evict();
+    }
+
+    void Rewinder::worker_loop()
+    {
+        std::vector<uint8_t> scratch;
+        while (true)
+        {
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                worker_cv_.wait(lock, [this] { return has_pending_ || quit_; });
+                if (quit_)
+                {
+                    return;
+                }
+                std::swap(pending_, work_);
+                has_pending_ = false;
+                busy_ = true;
+            }
+
+            Delta delta{};
+            bool has_delta = !latest_.empty();
+            if (has_delta)
+            {
+                encode(latest_, work_, scratch);
+                delta.data.assign(scratch.begin(), scratch.end());
+                delta.size = latest_.size();
+            }
+            // work_ keeps the old buffer around for the next state
+            std::swap(latest_, work_);
+
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (has_delta)
+                {
+                    deltas_size_ += delta.data.size();
+                    deltas_.push_back(std::move(delta));
+                }
+                evict();
+                busy_ = false;
+            }
+            idle_cv_.notify_all();
+        }
+    }
+
+    void Rewinder::wait_idle(std::unique_lock<std::mutex>& lock)
+    {
+        worker_cv_.notify_one();
+        idle_cv_.wait(lock, [this] { return !has_pending_ && !busy_; });
+    }
+
+    void Rewinder::evict()
+    {
+        while (!deltas_.empty() && latest_.size() + deltas_size_ > budget_)
+        {
+            deltas_size_ -= deltas_.front().data.size();
+            deltas_.pop_front();
+        }
+    }
+
+    // Deltas are a list of zero run length, literal length and literal bytes triples covering
+    // the XOR of both states, with the shorter one padded with zeroes
+    void Rewinder::encode(const std::vector<uint8_t>& prev, const std::vector<uint8_t>& next,
+                          std::vector<uint8_t>& out)
+    {
+        out.clear();
+        size_t common = std::min(prev.size(), next.size());
+        size_t size = std::max(prev.size(), next.size());
+        auto xor_at = [&](size_t i) -> uint8_t {
+            uint8_t a = i < prev.size() ? prev[i] : 0;
+            uint8_t b = i < next.size() ? next[i] : 0;
+            return a ^ b;
+        };
+
+        size_t i = 0;
+        while (i < size)
+        {
+            size_t zero_start = i;
+            while (i + 8 <= common && load64(&prev[i]) == load64(&next[i]))
+            {
+                i += 8;
+            }
+            while (i < size && xor_at(i) == 0)
+            {
+                i++;
+            }
+            write_varint(out, i - zero_start);
+
+            // Short zero runs inside a literal cost more to split off than to store
+            size_t literal_start = i;
+            size_t zeroes = 0;
+            while (i < size && zeroes < 8)
+            {
+                zeroes = xor_at(i) == 0 ? zeroes + 1 : 0;
+                i++;
+            }
+            i -= zeroes;
+            write_varint(out, i - literal_start);
+            for (size_t j = literal_start; j < i; j++)
+            {
+                out.push_back(xor_at(j));
+            }
+        }
+    }
+
+    void Rewinder::apply(std::vector<uint8_t>& state, const Delta& delta)
+    {
+        state.resize(std::max(state.size(), delta.size));
+        const uint8_t* ptr = delta.data.data();
+        const uint8_t* end = ptr + delta.data.size();
+        size_t i = 0;
+        while (ptr < end)
+        {
+            i += read_varint(ptr);
+            size_t literal = read_varint(ptr);
+            for (size_t j = 0; j < literal; j++)
+            {
+                state[i + j] ^= ptr[j];
+            }
+            ptr += literal;
+            i += literal;
+        }
+        state.resize(delta.size);
+    }
+} // namespace hydra
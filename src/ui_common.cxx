@@ -1,4 +1,5 @@
 #include <core.hxx>
+#include <cstring>
 #include <error_factory.hxx>
 #include <iostream>
 #include <n64/n64_hc.hxx>
@@ -47,7 +48,11 @@ namespace hydra
         {
             case EmuType::N64:
             {
-                emulator = std::make_unique<hydra::HydraCore_N64>();
+                auto n64 = std::make_unique<hydra::HydraCore_N64>();
+                n64->SetRSPThreaded(Settings::Get("n64_rsp_thread") == "true");
+                n64->SetRDPThreaded(Settings::Get("n64_rdp_thread") != "false");
+                n64->SetFastmem(Settings::Get("n64_fastmem") != "false");
+                emulator = std::move(n64);
                 auto ipl_path = Settings::Get("n64_ipl_path");
                 if (ipl_path.empty())
                 {
@@ -89,4 +94,31 @@ namespace hydra
 
         return hydra::EmuType::EmuTypeSize;
     }
+
+    void UiCommon::ConvertToRGBA8888(const VideoInfo& frame, std::vector<uint8_t>& out)
+    {
+        out.resize(frame.width * frame.height * 4);
+        for (uint32_t y = 0; y < frame.height; y++)
+        {
+            const uint8_t* row = frame.data.data() + y * frame.stride;
+            uint8_t* out_row = out.data() + y * frame.width * 4;
+            if (frame.format == VideoFormat::RGBA8888)
+            {
+                memcpy(out_row, row, frame.width * 4);
+                continue;
+            }
+
+            for (uint32_t x = 0; x < frame.width; x++)
+            {
+                uint16_t pixel = row[x * 2] << 8 | row[x * 2 + 1];
+                uint8_t r = (pixel >> 11) & 0x1F;
+                uint8_t g = (pixel >> 6) & 0x1F;
+                uint8_t b = (pixel >> 1) & 0x1F;
+                out_row[x * 4] = (r << 3) | (r >> 2);
+                out_row[x * 4 + 1] = (g << 3) | (g >> 2);
+                out_row[x * 4 + 2] = (b << 3) | (b >> 2);
+                out_row[x * 4 + 3] = 0xFF;
+            }
+        }
+    }
 } // namespace hydra
\ No newline at end of file